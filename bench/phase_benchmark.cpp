@@ -0,0 +1,180 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <algorithm>
+
+#include "tissue.h"
+#include "functions.h"
+#include "model.h"
+
+//times every phase of Tissue::run on its own for synthetic hexagonal tissues and writes ns per entity as json
+//usage: phase_benchmark [--sizes 1000,10000,...] [--threads n] [--seconds s] [--out file.json] [--dir output/]
+
+
+static double half_width; 		//cells are kept inside a square a little smaller than the seeded one
+static bool inside(const Point& p) { return std::fabs(p.x()) < half_width && std::fabs(p.y()) < half_width; }
+
+struct Result
+{
+	long cells;
+	std::string phase;
+	std::string entity;
+	long entities;
+	double ns;
+};
+
+class PhaseBenchmark
+{
+private:
+
+	double seconds_; 		//minimum time of each of the batches a phase is timed in
+	std::string dir_;
+	int threads_;
+
+	template <typename F>
+	double once(F f) const 		//seconds for a single call, for phases too slow or too noisy to repeat
+	{
+		auto start = std::chrono::steady_clock::now();
+		f();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	template <typename F>
+	double time(F f) const 		//best of three batches, seconds per call
+	{
+		f();
+		double best = std::numeric_limits<double>::infinity();
+		for (int batch = 0; batch < 3; batch++)
+		{
+			long reps = 0;
+			auto start = std::chrono::steady_clock::now();
+			double elapsed = 0;
+			do
+			{
+				f();
+				reps++;
+				elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			} while (elapsed < seconds_);
+			best = std::min(best, elapsed/reps);
+		}
+		return best;
+	}
+	template <typename F>
+	double fresh(const std::string& checkpoint, F f) const 		//best of three single calls, each on its own copy restored from checkpoint, for phases that change the tissue
+	{
+		double best = std::numeric_limits<double>::infinity();
+		for (int copy = 0; copy < 3; copy++)
+		{
+			Tissue T(checkpoint);
+			T.setThreads(threads_);
+			best = std::min(best, once([&]() { f(T); }));
+		}
+		return best;
+	}
+
+public:
+
+	PhaseBenchmark(double seconds, const std::string& dir, int threads) : seconds_(seconds), dir_(dir), threads_(threads) {}
+
+	void run(unsigned int n, std::vector<Result>& results)
+	{
+		std::vector<Point> points = hexagonalWithNoise(n, 0.1);
+		half_width = 0.45*std::sqrt(n);
+		CellMesh mesh = voronoiCells(points);
+
+		std::unique_ptr<Tissue> built;
+		double t_build = once([&]() { built.reset(new Tissue(mesh, inside)); });
+		Tissue& T = *built;
+		T.setThreads(threads_);
+		ThreadPool pool(threads_); 		//same split as the tissue's own pool, for kernels timed without the rest of their phase
+		long C = T.cells().size(); long E = T.edges().size(); long V = T.vertices().size();
+		auto add = [&](const std::string& phase, const std::string& entity, long count, double t)
+		{
+			results.push_back({C, phase, entity, count, 1e9*t/count});
+			std::printf("%9ld cells  %-18s %10.2f ns/%s\n", C, phase.c_str(), 1e9*t/count, entity.c_str());
+		};
+		add("construction", "cell", C, t_build);
+
+		//the start of a step first so every derived quantity the phases read is set
+		for (Vertex* v : T.vertices()) v->onBoundaryCell();
+		T.runPhase(PHASE_TRANSITIONS);
+		T.runPhase(PHASE_GEOMETRY);
+		const std::string checkpoint = dir_ + "bench_checkpoint.bin";
+		T.writeCheckpoint(checkpoint);
+
+		add("edge_lengths", "edge", E, time([&]() { pool.forEach(T.edges(), [](Edge* e) { e->calcLength(); }); }));
+		add("cell_geometry", "cell", C, time([&]() { T.runPhase(PHASE_GEOMETRY); }));
+		add("calcT_l", "edge", E, time([&]() { pool.forEach(T.edges(), [&T](Edge* e) { e->calcT_l<StandardModel>(T.param()); }); }));
+		add("calcForce_vertex", "vertex", V, time([&]() { pool.forEach(T.vertices(), [](Vertex* v) { v->calcForce(); }); }));
+		add("calcForce_edge", "vertex", V, time([&]()
+		{
+			pool.forEach(T.edges(), [](Edge* e) { e->calcForce(); });
+			pool.forEach(T.vertices(), [](Vertex* v) { v->gatherForce(); });
+		}));
+		//zero time step so every repetition sees the same tissue
+		add("applyForce", "vertex", V, time([&]() { pool.reduce(T.vertices(), 0.0, [&T](Vertex* v) { return v->applyForce<StandardModel>(T.param(), 0.0); }, [](double a, double b) { return std::max(a, b); }); }));
+		add("calcm", "cell+vertex", C + V, time([&]() { T.runPhase(PHASE_CALCM); }));
+		add("countDefects", "cell+vertex", C + V, time([&]() { T.countDefects(); }));
+		
+		//these change the tissue, so each call gets a fresh copy that still has all of its work to do
+		add("T1", "edge", E, fresh(checkpoint, [](Tissue& R) { R.runPhase(PHASE_T1); })); 		//a restored tissue rebuilds its short edge list, the worst case of a step
+		add("transitions", "cell", C, fresh(checkpoint, [](Tissue& R) { R.runPhase(PHASE_TRANSITIONS); }));
+		std::remove(checkpoint.c_str());
+
+		Polygons cells;
+		add("write_vtu", "cell", C, time([&]() { fillCells(&T, cells); writePolygonsVTU(cells, dir_ + "bench_cells.vtu"); }));
+		add("write_vtk", "cell", C, time([&]() { fillCells(&T, cells); writePolygonsVTK(cells, dir_ + "bench_cells.vtk", "Cells"); }));
+	}
+};
+
+static void writeJson(const std::vector<Result>& results, int threads, const std::string& filename)
+{
+	std::ofstream file(filename);
+	file << "{\n  \"benchmark\": \"phases\",\n  \"threads\": " << threads << ",\n  \"results\": [\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const Result& r = results[i];
+		file << "    {\"cells\": " << r.cells << ", \"phase\": \"" << r.phase << "\", \"entity\": \"" << r.entity
+			 << "\", \"entities\": " << r.entities << ", \"ns_per_entity\": " << r.ns << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	file << "  ]\n}\n";
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<unsigned int> sizes = {1000, 10000, 100000, 1000000};
+	int threads = 1;
+	double seconds = 0.2;
+	std::string out = "phase_benchmark.json";
+	std::string dir = "";
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		std::string arg = argv[i];
+		if (arg == "--sizes")
+		{
+			sizes.clear();
+			std::stringstream list(argv[i+1]);
+			std::string size;
+			while (std::getline(list, size, ',')) sizes.push_back(std::stoul(size));
+		}
+		else if (arg == "--threads") threads = std::atoi(argv[i+1]);
+		else if (arg == "--seconds") seconds = std::atof(argv[i+1]);
+		else if (arg == "--out") out = argv[i+1];
+		else if (arg == "--dir") dir = argv[i+1];
+		else { std::cerr << "unknown option " << arg << '\n'; return 1; }
+	}
+
+	std::vector<Result> results;
+	PhaseBenchmark bench(seconds, dir, threads);
+	for (unsigned int n : sizes) bench.run(n, results);
+	writeJson(results, threads, out);
+	std::cout << "written to " << out << '\n';
+	return 0;
+}
@@ -0,0 +1,232 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "tissue.h"
+#include "functions.h"
+
+//runs a fixed proliferating tissue for a number of steps at every size and thread count and writes throughput as json,
+//each run is forked so its peak memory is its own, a previous output can be given as baseline to check for regressions
+//usage: scaling_benchmark [--sizes 1000,10000,...] [--threads 1,2,4,...] [--steps n] [--out file.json] [--baseline file.json] [--tolerance 0.1]
+
+
+static double radius_squared; 		//circular tissue inside the seeded square
+static bool disc(const Point& p) { return p.x()*p.x() + p.y()*p.y() < radius_squared; }
+
+//fixed scenario, changing any of these invalidates stored baselines
+static Parameters scenario()
+{
+	Parameters p;
+	p.set_GAMMA(0.2);
+	p.set_LAMBDA(-0.3);
+	p.A_max = 1.05*p.A_0; 		//just above the seeded areas so cells keep dividing
+	return p;
+}
+
+struct Sample 		//sent back from the forked run
+{
+	double seconds;
+	long cells_start;
+	long cells_end;
+	TopologyEvents events;
+};
+
+struct Result
+{
+	long size;
+	int threads;
+	long cells;
+	double seconds;
+	double steps_per_s;
+	double cell_updates_per_s;
+	long peak_rss_kb;
+	TopologyEvents events;
+};
+
+static Sample runScenario(unsigned int n, int threads, int steps)
+{
+	std::vector<Point> points = hexagonalWithNoise(n, 0.1);
+	radius_squared = 0.2*n;
+	CellMesh mesh = voronoiCells(points);
+	Tissue T(mesh, disc);
+	T.setParameters(scenario());
+	T.setThreads(threads);
+	T.setAdaptive(true);
+	T.setDefectRecording(0, 1, false);
+
+	Sample s;
+	s.cells_start = T.cells().size();
+	auto start = std::chrono::steady_clock::now();
+	T.run(steps, "");
+	s.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	s.cells_end = T.cells().size();
+	s.events = T.events();
+	return s;
+}
+
+static bool measure(unsigned int n, int threads, int steps, Result& r)
+{
+	int fd[2];
+	if (pipe(fd) != 0) return false;
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		close(fd[0]);
+		int null = open("/dev/null", O_WRONLY); 		//the model reports to stdout as it runs
+		dup2(null, STDOUT_FILENO);
+		Sample s = runScenario(n, threads, steps);
+		bool ok = write(fd[1], &s, sizeof(s)) == sizeof(s);
+		_exit(ok ? 0 : 1);
+	}
+	close(fd[1]);
+	Sample s;
+	bool ok = read(fd[0], &s, sizeof(s)) == sizeof(s);
+	close(fd[0]);
+	int status;
+	struct rusage usage;
+	wait4(pid, &status, 0, &usage);
+	if (!ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0) return false;
+
+	r.size = n;
+	r.threads = threads;
+	r.cells = s.cells_start;
+	r.seconds = s.seconds;
+	r.steps_per_s = steps/s.seconds;
+	r.cell_updates_per_s = 0.5*(s.cells_start + s.cells_end)*steps/s.seconds; 		//cell count taken as the mean of the first and last step
+	r.peak_rss_kb = usage.ru_maxrss;
+	r.events = s.events;
+	return true;
+}
+
+static void writeJson(const std::vector<Result>& results, int steps, const std::string& filename)
+{
+	std::ofstream file(filename);
+	file << "{\n  \"benchmark\": \"scaling\",\n  \"steps\": " << steps << ",\n  \"results\": [\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const Result& r = results[i];
+		file << "    {\"size\": " << r.size << ", \"threads\": " << r.threads << ", \"cells\": " << r.cells << ", \"seconds\": " << r.seconds
+			 << ", \"steps_per_s\": " << r.steps_per_s << ", \"cell_updates_per_s\": " << r.cell_updates_per_s << ", \"peak_rss_kb\": " << r.peak_rss_kb
+			 << ", \"T1\": " << r.events.T1 << ", \"T1_split\": " << r.events.T1_split << ", \"divisions\": " << r.events.divisions
+			 << ", \"extrusions\": " << r.events.extrusions << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	file << "  ]\n}\n";
+}
+
+//baselines are read back line by line, relying on writeJson() putting one result on each line
+static double field(const std::string& line, const std::string& key)
+{
+	size_t i = line.find("\"" + key + "\": ");
+	return i == std::string::npos ? NAN : std::atof(line.c_str() + i + key.size() + 4);
+}
+static std::vector<Result> readJson(const std::string& filename, int& steps)
+{
+	std::ifstream file(filename);
+	if (!file) throw std::runtime_error("could not open baseline " + filename);
+	std::vector<Result> results;
+	std::string line;
+	steps = 0;
+	while (std::getline(file, line))
+	{
+		if (line.find("\"steps\": ") != std::string::npos && line.find("\"size\"") == std::string::npos) steps = field(line, "steps");
+		if (line.find("\"size\"") == std::string::npos) continue;
+		Result r;
+		r.size = field(line, "size"); r.threads = field(line, "threads"); r.cells = field(line, "cells");
+		r.seconds = field(line, "seconds"); r.steps_per_s = field(line, "steps_per_s"); r.cell_updates_per_s = field(line, "cell_updates_per_s");
+		r.peak_rss_kb = field(line, "peak_rss_kb");
+		r.events.T1 = field(line, "T1"); r.events.T1_split = field(line, "T1_split");
+		r.events.divisions = field(line, "divisions"); r.events.extrusions = field(line, "extrusions");
+		results.push_back(r);
+	}
+	return results;
+}
+
+//throughput and memory may drift by tolerance, the run is deterministic so event counts must match exactly
+static int compare(const std::vector<Result>& results, const std::vector<Result>& baseline, double tolerance)
+{
+	int regressions = 0;
+	for (const Result& r : results)
+	{
+		const Result* b = nullptr;
+		for (const Result& x : baseline) if (x.size == r.size && x.threads == r.threads) b = &x;
+		if (b == nullptr) { std::printf("%8ld x%-3d no baseline\n", r.size, r.threads); continue; }
+
+		std::vector<std::string> problems;
+		if (r.steps_per_s < (1 - tolerance)*b->steps_per_s) problems.push_back("throughput " + std::to_string(r.steps_per_s/b->steps_per_s) + "x baseline");
+		if (r.peak_rss_kb > (1 + tolerance)*b->peak_rss_kb) problems.push_back("memory " + std::to_string(static_cast<double>(r.peak_rss_kb)/b->peak_rss_kb) + "x baseline");
+		if (r.cells != b->cells || r.events.T1 != b->events.T1 || r.events.T1_split != b->events.T1_split
+			|| r.events.divisions != b->events.divisions || r.events.extrusions != b->events.extrusions) problems.push_back("topology events differ");
+
+		std::printf("%8ld x%-3d %6.2fx steps/s  %6.2fx rss  ", r.size, r.threads, r.steps_per_s/b->steps_per_s, static_cast<double>(r.peak_rss_kb)/b->peak_rss_kb);
+		if (problems.empty()) std::printf("ok\n");
+		for (size_t i = 0; i < problems.size(); i++) std::printf("%s%s", problems[i].c_str(), i + 1 < problems.size() ? ", " : "\n");
+		regressions += !problems.empty();
+	}
+	return regressions;
+}
+
+static std::vector<long> list(const std::string& s)
+{
+	std::vector<long> values;
+	std::stringstream ss(s);
+	std::string value;
+	while (std::getline(ss, value, ',')) values.push_back(std::stol(value));
+	return values;
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<long> sizes = {1000, 10000, 100000};
+	std::vector<long> threads = {1, 2, 4, 8};
+	int steps = 200;
+	std::string out = "scaling_benchmark.json";
+	std::string baseline = "";
+	double tolerance = 0.1;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		std::string arg = argv[i];
+		if (arg == "--sizes") sizes = list(argv[i+1]);
+		else if (arg == "--threads") threads = list(argv[i+1]);
+		else if (arg == "--steps") steps = std::atoi(argv[i+1]);
+		else if (arg == "--out") out = argv[i+1];
+		else if (arg == "--baseline") baseline = argv[i+1];
+		else if (arg == "--tolerance") tolerance = std::atof(argv[i+1]);
+		else { std::cerr << "unknown option " << arg << '\n'; return 1; }
+	}
+
+	std::vector<Result> results;
+	std::printf("%8s %7s %8s %10s %14s %12s %8s %8s %9s %10s\n", "size", "threads", "cells", "steps/s", "cell-updates/s", "peak rss kb", "T1", "T1 split", "divisions", "extrusions");
+	for (long n : sizes)
+	{
+		for (long t : threads)
+		{
+			Result r;
+			if (!measure(n, t, steps, r)) { std::cerr << "run of size " << n << " on " << t << " threads failed\n"; return 1; }
+			std::printf("%8ld %7d %8ld %10.2f %14.4g %12ld %8ld %8ld %9ld %10ld\n", r.size, r.threads, r.cells, r.steps_per_s, r.cell_updates_per_s, r.peak_rss_kb,
+						r.events.T1, r.events.T1_split, r.events.divisions, r.events.extrusions);
+			results.push_back(r);
+		}
+	}
+	writeJson(results, steps, out);
+	std::cout << "written to " << out << '\n';
+
+	if (baseline.empty()) return 0;
+	int baseline_steps;
+	std::vector<Result> base = readJson(baseline, baseline_steps);
+	if (baseline_steps != steps) { std::cerr << "baseline ran " << baseline_steps << " steps, not " << steps << '\n'; return 1; }
+	int regressions = compare(results, base, tolerance);
+	std::cout << regressions << " regressions against " << baseline << '\n';
+	return regressions > 0 ? 2 : 0;
+}
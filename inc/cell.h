@@ -9,7 +9,9 @@
 #include <iostream>
 
 #include "parameters.h"
-#include "libraries.h"
+#include "vec2.h"
+#include "halfedge.h"
+#include "checkpoint.h"
 
 class Tissue;
 
@@ -22,10 +24,11 @@ class Cell
 private:
 
 	Tissue* T;
+	int id_;
     
-    std::vector<Vertex*> vertices_;
-    std::vector<Edge*> edges_;
+    HalfEdge* h_; 				//any half-edge of the cell's loop
     std::vector<Cell*> neighbours_;
+    std::vector<Edge*> neighbour_edges_; 	//edge between each neighbour and the next, nullptr if they only share a vertex
 
     Point r_0_;
     double A_; double S_; 		//cell area, area sign (+1 or -1)
@@ -35,16 +38,23 @@ private:
     double G[3];				//gyration tensor symmetric so only need 3 values (a b, b c)
     double lambda; 				//gyration tensor largest eigenvalue
     double Z_, X_; 				//for defect analysis
+    double Zn_, Xn_; 			//(Z, X) normalised
     Vec n_; 					//normalised director
     double m_; 					//winding number around cell nearest neighbors
     
-    const int longestEdge_i() const;
+    HalfEdge* const longestEdge() const;
+    void shape(); 				//director and (Z, X) from the gyration tensor
+    
+    friend class CellGeometry; 	//fills in the shape of many cells at once
     
 public:
 
-    Cell(Tissue* T, std::vector<Vertex*>& vertices, std::vector<Edge*>& edges);
+    Cell(Tissue* T, int id, HalfEdge* h);
     Cell();
+    Cell(const Cell&) = delete;
+    Cell& operator=(const Cell&) = delete;
     
+    const int id() const;
     const Point& r_0() const;
     const double A() const; 
     const double S() const;
@@ -53,35 +63,34 @@ public:
     const Vec& n() const;
     const double Z() const; 
     const double X() const;
+    const double Zn() const;
+    const double Xn() const;
     const double m() const;
-    const std::vector<Vertex*>& vertices() 	const;
-    const std::vector<Edge*>& edges() 		const;
+    HalfEdge* const h() const;
+    const HalfEdgeLoop halfEdges() const; 	//half-edges in vertex order, h->v is the i-th vertex and h->e the i-th edge
+    const int size() const; 					//number of vertices
     const std::vector<Cell*>& neighbours() 	const;
     
-       
-    void addVertex(Vertex* v, int i);
-    void removeVertex(Vertex* v);
-    void exchangeVertex(Vertex* v_old, Vertex* v_new);
-    void rotateVertices();
-    
-    void addEdge(Edge* e, int i);
-    int removeEdge(Edge* e);
+    void setH(HalfEdge* h);
     
     const bool hasEdge(Edge* e) const;
     const bool onBoundary() const;
     void findNeighbours();
     
-    void extrude();
-	void divide();
+    const bool extrude(); 		//whether the cell was removed
+	const bool divide(); 		//whether the cell was split
     
     void calcR_0();
     void calcA();
     void calcL();
-    void calcT_A();
+    template <typename Model> void calcT_A(const Parameters& p); 		//kernels templated on the model are defined in model.h
     void calcG();
     void calcm();
     
     bool valid();
+    
+    void save(CheckpointOut& out) const;
+    void load(CheckpointIn& in, Tissue* tissue, int id);
       
     void outputVertices() const;
     void outputEdges() const;
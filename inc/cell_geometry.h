@@ -0,0 +1,50 @@
+#ifndef CELL_GEOMETRY_H
+#define CELL_GEOMETRY_H
+
+#include <vector>
+
+#include "slab.h"
+#include "thread_pool.h"
+#include "parameters.h"
+
+class Vertex;
+class Edge;
+class Cell;
+
+
+//fused per step shape kernel, edge lengths then perimeter, centroid, gyration tensor, director and area tension of every cell
+//corner vertex and edge ids of LANES cells are interleaved, corner k of every cell of a block side by side,
+//so the inner loops run across cells and compile to vector instructions over gathered positions
+//rows are kept by cell id and only rebuilt for cells whose loop has changed since the last step
+//every cell still adds up its own corners in loop order, so results are the same as the per cell calc functions
+class CellGeometry
+{
+public:
+
+	static constexpr int LANES = 8;
+
+private:
+
+	int width_; 						//corners per row, a longer loop makes every row wider
+	std::vector<int> n_; 				//corners of each cell id, 0 for a dead slot
+	std::vector<int> v_id_; 			//[(block*width_ + k)*LANES + lane], padded with corner 0
+	std::vector<int> e_id_;
+	std::vector<int> dirty_; 			//ids of cells whose rows must be rebuilt
+	std::vector<char> is_dirty_;
+	bool relayout_;
+	
+	std::vector<double> x_, y_, l_; 	//vertex positions and edge lengths by id, gathered every step
+	
+	void buildRow(const Slab<Cell>& c_arr, int id);
+	template <typename Model> void block(Slab<Cell>& c_arr, const Parameters& p, int b);
+
+public:
+
+	CellGeometry();
+	
+	void touch(int id); 				//loop of cell id changed or the cell was created or destroyed
+	void touchAll();
+	template <typename Model> void update(Slab<Vertex>& v_arr, Slab<Edge>& e_arr, Slab<Cell>& c_arr, ThreadPool& pool, const Parameters& p); 	//areas must already be current, area tensions are those of Model
+};
+
+#endif // CELL_GEOMETRY_H
@@ -0,0 +1,75 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+#include "vec2.h"
+
+#define CHECKPOINT_VERSION 8
+
+
+//binary checkpoint buffers, values are copied as raw bytes and pointers are stored as ids by the caller
+class CheckpointOut
+{
+private:
+
+	std::vector<char> buf_;
+
+public:
+
+	template <typename V>
+	void put(const V& x)
+	{
+		const char* p = reinterpret_cast<const char*>(&x);
+		buf_.insert(buf_.end(), p, p + sizeof(V));
+	}
+	template <typename V>
+	void put(const std::vector<V>& a)
+	{
+		put<uint64_t>(a.size());
+		const char* p = reinterpret_cast<const char*>(a.data());
+		buf_.insert(buf_.end(), p, p + a.size()*sizeof(V));
+	}
+	void put(const Vec2& u) { put(u.x()); put(u.y()); }
+
+	void write(const std::string& filename) const; 		//written next to filename first so a crash never leaves half a checkpoint
+};
+
+class CheckpointIn
+{
+private:
+
+	std::vector<char> buf_;
+	size_t pos_;
+
+	void need(size_t bytes) const;
+
+public:
+
+	CheckpointIn(const std::string& filename);
+
+	template <typename V>
+	V get()
+	{
+		V x;
+		need(sizeof(V));
+		std::memcpy(&x, buf_.data() + pos_, sizeof(V));
+		pos_ += sizeof(V);
+		return x;
+	}
+	template <typename V>
+	void get(std::vector<V>& a)
+	{
+		size_t n = get<uint64_t>();
+		need(n*sizeof(V));
+		a.resize(n);
+		std::memcpy(a.data(), buf_.data() + pos_, n*sizeof(V));
+		pos_ += n*sizeof(V);
+	}
+	Vec2 getVec2() { double x = get<double>(); double y = get<double>(); return Vec2(x, y); }
+};
+
+#endif // CHECKPOINT_H
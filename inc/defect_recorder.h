@@ -0,0 +1,59 @@
+#ifndef DEFECT_RECORDER_H
+#define DEFECT_RECORDER_H
+
+#include <array>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+
+#define DEFECT_FLUSH_ROWS 1000 		//rows held in memory before they are written out
+
+
+//defect counts streamed to a file during the run, memory does not grow with the number of timesteps
+//counts are sampled every interval timesteps and each row holds the mean of decimation samples
+//binary files start with "DEFECTS1" followed by rows of int32 timestep and float32 PLUSHALF, PLUSONE, MINUSHALF, MINUSONE
+//text files have the same columns under a header line
+class DefectRecorder
+{
+public:
+
+	struct State 		//enough to carry on with the same file from a checkpoint
+	{
+		uint64_t bytes; 					//length of the file, 0 if nothing was recorded
+		std::array<double, 4> sum; 			//samples of the unfinished row
+		int samples;
+		int first; 							//timestep of the first of them
+	};
+
+private:
+
+	std::ofstream file_;
+	std::string filename_;
+	int interval_;
+	int decimation_;
+	bool binary_;
+	
+	std::vector<char> buf_; 		//rows not yet written
+	int rows_;
+	uint64_t bytes_;
+	std::array<double, 4> sum_;
+	int samples_;
+	int first_;
+	
+	void addRow();
+
+public:
+
+	DefectRecorder(const std::string& filename, int interval, int decimation, bool binary, const State* resume); 	//resume truncates the file to where the checkpoint left it
+	~DefectRecorder();
+	DefectRecorder(const DefectRecorder&) = delete;
+	DefectRecorder& operator=(const DefectRecorder&) = delete;
+	
+	const bool due(int timestep) const { return timestep % interval_ == 0; }
+	void record(int timestep, const std::array<int, 4>& counts);
+	void flush(); 					//rows recorded so far are on disk, an unfinished row is kept back
+	State state(); 					//flushes first so the file matches the returned state
+};
+
+#endif // DEFECT_RECORDER_H
@@ -9,7 +9,10 @@
 #include <iostream>
 
 #include "parameters.h"
-#include "libraries.h"
+#include "vec2.h"
+#include "small_set.h"
+#include "halfedge.h"
+#include "checkpoint.h"
 #include "vertex.h"
 
 class Tissue;
@@ -22,34 +25,46 @@ class Edge
 private:
 	
 	Tissue* T;
-    Vertex* v_1; Vertex* v_2;
+	int id_;
+    HalfEdge h_[2]; //h_[0] starts at v1, h_[1] starts at v2
     double l_; //length
     double T_l_; //line tension
-    
-    std::unordered_set<Cell*> cell_junctions_;
+    Vec f_[2]; //force from this edge on v1 and v2
+    double turn_s_, turn_c_; //cross and dot of the normalised (Z, X) of the cells from h_[0] to h_[1]
   
 public:
 
-    Edge(Tissue* T, Vertex* v_1, Vertex* v_2);
+    Edge(Tissue* T, int id, Vertex* v_1, Vertex* v_2);
     Edge();
+    Edge(const Edge&) = delete;
+    Edge& operator=(const Edge&) = delete;
     bool operator==(const Edge& other) const;
 
+    const int id() const;
     Vertex* const v1() const; Vertex* const v2() const;
     const double l() const;
     const double T_l() const;
-    const std::unordered_set<Cell*>& cellJunctions() const;
-
-    void addCellJunction(Cell* c);
-    void removeCellJunction(Cell* c);
+    const SmallSet<Cell*, 2> cellJunctions() const;
+    const Vec& force(Vertex* v) const;
+    
+    HalfEdge* const h(int i);
+    HalfEdge* const from(Vertex* v); 	//half-edge starting at v
     
     const bool hasVertex(Vertex* v) const;
-    bool swapVertex(Vertex* v_old, Vertex* v_new); //changes cell vertices
-    bool swapVertex_noedit(Vertex* v_old, Vertex* v_new);
+    bool swapVertex(Vertex* v_old, Vertex* v_new); //moves endpoint of edge, cells are left to the caller
     
     void calcLength();
-    void calcT_l();
+    template <typename Model> void calcT_l(const Parameters& p); 		//kernels templated on the model are defined in model.h
+    void calcForce();
+    void calcTurn(); 					//cell shapes must already be calculated
+    const double turnS(Cell* from) const; 	//sine of the turn from cell from to the other cell
+    const double turnC() const;
+    template <typename Model> const double maxStep(const Parameters& p) const; 		//longest time step allowed by how fast the edge changes, forces must already be calculated
+    
+    const bool T1(); 		//whether the edge was swapped
     
-    void T1();
+    void save(CheckpointOut& out) const;
+    void load(CheckpointIn& in, Tissue* tissue, int id);
 
 };
 
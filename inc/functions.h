@@ -5,11 +5,18 @@
 #include <unordered_map>
 #include <string>
 #include <fstream>
-#include <random>
+#include <sstream>
+#include <cstdint>
+#include <functional>
+#include <atomic>
+#include <memory>
 
 class Tissue;
 
-#include "libraries.h"
+#include "vec2.h"
+#include "voronoi.h"
+#include "philox.h"
+#include "snapshot_writer.h"
 #include "tissue.h"
 #include "vertex.h"
 #include "edge.h"
@@ -17,11 +24,44 @@ class Tissue;
 
 double random(double min, double max, unsigned int seed);
 
+//example voronoi seeds, seed i is drawn from counter i so the same seed always gives the same points
+std::vector<Point> randomPoints(unsigned int n, uint64_t seed = 1);
+std::vector<Point> hexagonalWithNoise(unsigned int n, double g, uint64_t seed = 1);
+
+//exact voronoi cells of hexagonalWithNoise(n, 0) built without CGAL, including the cells along the edge of the lattice,
+//which the diagram leaves unbounded
+CellMesh hexagonalCells(unsigned int n);
+
 void outputData(const Tissue& Tissue);
 
+//copy the tissue into flat arrays for output
+void fillCells(Tissue* T, Polygons& cells);
+void fillDirectors(Tissue* T, std::vector<float>& directors);
+void fillCellDefects(const std::vector<Cell*>& c_def, Polygons& defects);
+void fillVertexDefects(const std::vector<Vertex*>& v_def, std::vector<float>& defects);
+
+//legacy ASCII .vtk and binary VTK XML with raw appended data
+void writePolygonsVTK(const Polygons& p, const std::string& filename, const std::string& name);
+void writeLinesVTK(const std::vector<float>& points, const std::string& filename);
+void writePointsVTK(const std::vector<float>& points, const std::string& filename);
+void writePolygonsVTU(const Polygons& p, const std::string& filename);
+void writeLinesVTP(const std::vector<float>& points, const std::string& filename);
+void writePointsVTP(const std::vector<float>& points, const std::string& filename);
+
 void writeCellsFile(Tissue* T, const std::string& filename_cells);
 void writeDirectorsFile(Tissue* T, const std::string& filename_directors);
 void writeCellDefectsFile(Tissue* T, const std::vector<Cell*>& c_def, const std::string& filename_c_def);
 void writeVertexDefectsFile(Tissue* T, const std::vector<Vertex*>& v_def, const std::string& filename_v_def);
 
+void writeCellsFileVTU(Tissue* T, const std::string& filename_cells);
+void writeDirectorsFileVTP(Tissue* T, const std::string& filename_directors);
+void writeCellDefectsFileVTU(const std::vector<Cell*>& c_def, const std::string& filename_c_def);
+void writeVertexDefectsFileVTP(const std::vector<Vertex*>& v_def, const std::string& filename_v_def);
+
+void writeFrame(const Frame& f); 		//every file of one snapshot
+
+//run one tissue per parameter set concurrently, output files are prefixed with the index of the set
+//setup is called on every tissue before it runs, e.g. to choose its output options
+void runEnsemble(const CellMesh& mesh, bool (*in)(const Point&), const std::vector<Parameters>& params, int timesteps, int threads, const std::function<void(Tissue&)>& setup);
+
 #endif // FUNCTIONS_H
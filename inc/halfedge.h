@@ -0,0 +1,49 @@
+#ifndef HALFEDGE_H
+#define HALFEDGE_H
+
+class Vertex;
+class Edge;
+class Cell;
+
+
+//one side of an edge, the half-edges of a cell are linked into a loop in the cell's vertex order
+//half-edges on the tissue boundary have no cell and are not linked
+struct HalfEdge
+{
+	Vertex* v; 			//origin vertex
+	Edge* e; 			//edge this half-edge is a side of
+	Cell* c; 			//cell this half-edge bounds, nullptr on the boundary
+	HalfEdge* twin; 	//other side of e
+	HalfEdge* next; 	//next half-edge around c
+	HalfEdge* prev; 	//previous half-edge around c
+};
+
+inline void link(HalfEdge* a, HalfEdge* b) { a->next = b; b->prev = a; }
+
+
+//range over a half-edge loop, usage: for (HalfEdge* h : c->halfEdges())
+class HalfEdgeLoop
+{
+private:
+
+	HalfEdge* h_0;
+
+public:
+
+	class iterator
+	{
+	private:
+		HalfEdge* h; HalfEdge* h_0; bool lapped;
+	public:
+		iterator(HalfEdge* h, bool lapped) : h(h), h_0(h), lapped(lapped) {}
+		HalfEdge* operator*() const { return h; }
+		iterator& operator++() { h = h->next; lapped = (h == h_0); return *this; }
+		bool operator!=(const iterator& other) const { return h != other.h || lapped != other.lapped; }
+	};
+	
+	HalfEdgeLoop(HalfEdge* h_0) : h_0(h_0) {}
+	iterator begin() const { return iterator(h_0, false); }
+	iterator end() const { return iterator(h_0, true); }
+};
+
+#endif // HALFEDGE_H
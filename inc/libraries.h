@@ -1,13 +1,13 @@
 #ifndef LIBRARIES_H
 #define LIBRARIES_H
 
+//CGAL is only used to build the initial voronoi tessellation, include this only where a diagram is handled directly
+
 #include <CGAL/Kernel/global_functions.h>
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 #include <CGAL/Point_2.h>
-#include <CGAL/Vector_2.h>
 typedef CGAL::Exact_predicates_inexact_constructions_kernel                   K;
-typedef CGAL::Vector_2<K>                                                   Vec;
-typedef CGAL::Point_2<K>												  Point;
+typedef CGAL::Point_2<K>												   Site;
 
 #include <CGAL/Delaunay_triangulation_2.h>
 #include <CGAL/Delaunay_triangulation_adaptation_traits_2.h>
@@ -18,4 +18,17 @@ typedef CGAL::Delaunay_triangulation_adaptation_traits_2<DT>                 AT;
 typedef CGAL::Delaunay_triangulation_caching_degeneracy_removal_policy_2<DT> AP;
 typedef CGAL::Voronoi_diagram_2<DT,AT,AP>                                    VD;
 
+//triangulation whose faces hold the index of their voronoi vertex, so cells are read off it without building a VD
+#include <CGAL/Triangulation_vertex_base_2.h>
+#include <CGAL/Triangulation_face_base_with_info_2.h>
+#include <CGAL/Triangulation_data_structure_2.h>
+typedef CGAL::Triangulation_vertex_base_2<K>                                 Vb;
+typedef CGAL::Triangulation_face_base_with_info_2<int, K>                    Fb;
+typedef CGAL::Triangulation_data_structure_2<Vb, Fb>                         TDS;
+typedef CGAL::Delaunay_triangulation_2<K, TDS>                               IndexedDT;
+
+#include "voronoi.h"
+
+CellMesh voronoiCells(const VD& vd);
+
 #endif // LIBRARIES_H
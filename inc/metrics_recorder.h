@@ -0,0 +1,81 @@
+#ifndef METRICS_RECORDER_H
+#define METRICS_RECORDER_H
+
+#include <array>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <cstdint>
+
+//phases of a timestep timed by MetricsRecorder
+#define PHASE_TRANSITIONS 0 	//recycle() and transitions()
+#define PHASE_GEOMETRY 1 		//edge lengths and cell shapes
+#define PHASE_FORCES 2 			//tensions and forces
+#define PHASE_INTEGRATION 3 	//time step and applyForce
+#define PHASE_CALCM 4 			//edge turns, cell and vertex calcm
+#define PHASE_DEFECTS 5 		//countDefects
+#define PHASE_OUTPUT 6 			//snapshots and checkpoints
+#define PHASE_T1 7 				//T1()
+#define PHASES 8
+
+
+//topology changes and entity turnover, counted since the tissue was built, carried through checkpoints
+struct TopologyEvents
+{
+	long T1 = 0;
+	long T1_split = 0;
+	long divisions = 0;
+	long extrusions = 0;
+	long vertices_created = 0;
+	long vertices_destroyed = 0;
+	long edges_created = 0;
+	long edges_destroyed = 0;
+	long cells_created = 0;
+	long cells_destroyed = 0;
+};
+
+//run metrics streamed to a file every interval timesteps, one row per interval
+//each row holds the wall time spent in every phase per timestep, steps/s and cell-updates/s over the interval,
+//the event counters so far and the live entity counts
+//text files are csv under a header line, json files hold one object per line so rows can be read while the run goes on
+class MetricsRecorder
+{
+private:
+
+	typedef std::chrono::steady_clock Clock;
+
+	std::ofstream file_;
+	std::string filename_;
+	int interval_;
+	bool json_;
+	uint64_t bytes_; 				//length of the file, every row is on disk once it is recorded
+
+	Clock::time_point last_; 		//end of the last lap
+	Clock::time_point row_start_;
+	std::array<double, PHASES> phase_; 	//seconds in each phase since the last row
+	int steps_; 					//timesteps since the last row
+	double cell_steps_; 			//cells summed over those timesteps
+
+	void write(const std::string& text);
+
+public:
+
+	MetricsRecorder(const std::string& filename, int interval, bool json, const uint64_t* resume); 	//resume truncates the file to the length a checkpoint saved
+	MetricsRecorder(const MetricsRecorder&) = delete;
+	MetricsRecorder& operator=(const MetricsRecorder&) = delete;
+
+	void startStep() { last_ = Clock::now(); }
+	void lap(int phase) 			//time since the last lap or startStep() was spent in phase
+	{
+		Clock::time_point now = Clock::now();
+		phase_[phase] += std::chrono::duration<double>(now - last_).count();
+		last_ = now;
+	}
+	void endStep(int cells) { steps_++; cell_steps_ += cells; }
+
+	const bool due(int timestep) const { return timestep % interval_ == 0; }
+	void record(int timestep, double time, const TopologyEvents& events, int vertices, int edges, int cells);
+	const uint64_t bytes() const { return bytes_; }
+};
+
+#endif // METRICS_RECORDER_H
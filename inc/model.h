@@ -0,0 +1,107 @@
+#ifndef MODEL_H
+#define MODEL_H
+
+#include <cmath>
+#include <algorithm>
+
+#include "parameters.h"
+#include "vec2.h"
+#include "vertex.h"
+#include "edge.h"
+#include "cell.h"
+#include "tissue.h"
+
+#define NOISE_SIGMAS 4 		//standard deviations of vertex noise adaptive steps allow for, wider noise is rare enough to leave to the T1 watch
+
+//energy functionals the force pipeline is compiled for, run<Model>() builds every kernel below for one model
+//so the tensions and boundary motion are inlined without branching or virtual calls
+//a model reads its parameters from Parameters, or fixes them as constexpr so they fold into the kernels
+
+//area elasticity K_a*(A - A_0), line tension LAMBDA plus contractility GAMMA*L of each cell either side,
+//and vertices of boundary cells turned about the origin instead of following their forces
+struct StandardModel
+{
+	static constexpr bool rotate_boundary = true;
+
+	static double areaTension(const Parameters& p, double A) { return p.K_a*(A - p.A_0); }
+	static double lineTension(const Parameters& p) { return p.LAMBDA; }
+	static double perimeterTension(const Parameters& p, double L) { return p.GAMMA*L; } 	//added for each cell along the edge
+};
+
+//standard energy with boundary vertices following their forces like the rest
+struct FreeBoundaryModel : StandardModel
+{
+	static constexpr bool rotate_boundary = false;
+};
+
+//perimeter elasticity about a target perimeter P_0 = p_0*sqrt(A_0), so cells either side add GAMMA*(L - P_0),
+//the target shape index p_0 is fixed at compile time, given in thousandths so it can be a template argument
+template <int P_0_MILLI = 3810>
+struct TargetPerimeterModel : StandardModel
+{
+	static constexpr double p_0 = P_0_MILLI/1000.0;
+
+	static double perimeterTension(const Parameters& p, double L) { return p.GAMMA*(L - p_0*std::sqrt(p.A_0)); }
+};
+
+//every model run() is compiled for, a new model is only usable once it is listed here
+#define FOR_EACH_MODEL(X) X(StandardModel) X(FreeBoundaryModel) X(TargetPerimeterModel<>)
+
+
+//kernels of the model dependent phases
+
+template <typename Model>
+void Cell::calcT_A(const Parameters& p) { T_A_ = Model::areaTension(p, A_); }
+
+template <typename Model>
+void Edge::calcT_l(const Parameters& p)
+{
+	T_l_ = Model::lineTension(p);
+	for (const HalfEdge& h : h_) if (h.c != nullptr) T_l_ += Model::perimeterTension(p, h.c->L());
+}
+
+template <typename Model>
+const Vec Vertex::velocity(const Parameters& p) const
+{
+	if constexpr (Model::rotate_boundary) return not_boundary_cell*p.a*force_ + 100*(1-not_boundary_cell)*p.a*Vec(-r_.y(),r_.x());
+	else return p.a*force_;
+}
+
+template <typename Model>
+const double Vertex::applyForce(const Parameters& p, double dt)
+{
+	Vec dr;
+	if constexpr (Model::rotate_boundary) dr = not_boundary_cell*p.a*dt*force_ + 100*(1-not_boundary_cell)*p.a*dt*Vec(-r_.y(),r_.x());
+	else dr = p.a*dt*force_;
+	if (p.D > 0) dr += std::sqrt(2*p.D*dt)*T->normal(RNG_VERTEX_NOISE, id_);
+	r_ += dr;
+	return dr.squared_length();
+}
+
+//largest dt with drift*dt + noise*sqrt(dt) <= length
+inline double stepWithin(double length, double drift, double noise)
+{
+	double x = 2*length/(noise + std::sqrt(noise*noise + 4*drift*length)); 	//sqrt(dt), written so it holds for no drift
+	return x*x;
+}
+
+template <typename Model>
+const double Edge::maxStep(const Parameters& p) const
+{
+	//only relative motion of the ends deforms the edge, rigid motion like the boundary rotation does not limit the step
+	Vec u = v2()->velocity<Model>(p) - v1()->velocity<Model>(p);
+	double speed = std::sqrt(u.squared_length());
+	double shrink = -(u*(v2()->r() - v1()->r()))/l_; 						//rate the edge gets shorter
+	if (p.D > 0)
+	{
+		//noise moves the ends apart by 2*sqrt(D*dt) along any direction at one sigma, growing as sqrt(dt), and it can
+		//shorten an edge that the forces lengthen
+		double noise = NOISE_SIGMAS*2*std::sqrt(p.D);
+		return std::min(stepWithin(p.step_fraction*l_, speed, noise), stepWithin(p.step_fraction*p.l_min, std::max(shrink, 0.0), noise));
+	}
+	double dt = p.step_fraction*l_/speed; 									//edge turns or stretches by a fraction of its length
+	if (shrink > 0) dt = std::min(dt, p.step_fraction*p.l_min/shrink); 		//and is seen below l_min before it can pass through zero
+	return dt;
+}
+
+#endif // MODEL_H
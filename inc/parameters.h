@@ -2,24 +2,34 @@
 #define	PARAMETERS_H
 
 #include <cmath>
+#include <cstdint>
 
-namespace param
+//model parameters, every Tissue owns its own set so independent runs can share a process
+struct Parameters
 {
-	extern const double dt;
-	extern const double a;
-	extern const double A_0;
-	extern const double K_a;
+	double dt; 				//fixed time step, also the smallest adaptive step
+	double dt_max; 			//largest adaptive step
+	double step_fraction; 	//adaptive steps turn or stretch an edge by at most this fraction of its length, and shorten it by at most this fraction of l_min, noise included
+	double a;
+	double A_0;
+	double K_a;
 	
-	extern const double l_min;
-	extern const double l_new;
-	extern const double A_min;
-	extern const double A_max;
+	double l_min;
+	double t1_skin; 		//edges up to l_min + t1_skin are watched for T1s, wider skins rescan less often
+	double l_new;
+	double A_min;
+	double A_max;
 	
-	extern double LAMBDA;
-	extern double GAMMA;
+	double LAMBDA;
+	double GAMMA;
 	
-	void set_LAMBDA(double LAMBDA_);
-	void set_GAMMA(double GAMMA_);
-}
+	double D; 				//vertex noise, random displacements of sqrt(2*D*dt) per coordinate each step, 0 for none
+	uint64_t seed; 			//key of every random number the tissue draws
+	
+	Parameters();
+	
+	void set_LAMBDA(double LAMBDA_); 		//in units of K_a*A_0^1.5
+	void set_GAMMA(double GAMMA_); 		//in units of K_a*A_0
+};
 
 #endif // PARAMETERS_H
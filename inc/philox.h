@@ -0,0 +1,56 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <array>
+#include <cstdint>
+#include <cmath>
+
+#include "vec2.h"
+
+//streams keep the draws made for different purposes apart
+#define RNG_SEEDING 0 			//initial voronoi seeds, counter is the seed index
+#define RNG_VERTEX_NOISE 1 		//vertex displacements, counter is vertex id and timestep
+
+
+//Philox4x32-10 counter based generator (Salmon et al. 2011), every block of output is a pure function of the key and a
+//128 bit counter, so there is no state to share between threads and a draw is the same whichever thread takes it in
+//whichever order, a few multiplies per block, two doubles come from each block
+class Philox
+{
+public:
+
+	static std::array<uint32_t, 4> block(uint64_t key, uint32_t c_0, uint32_t c_1, uint32_t c_2, uint32_t c_3)
+	{
+		uint32_t k_0 = static_cast<uint32_t>(key); uint32_t k_1 = static_cast<uint32_t>(key >> 32);
+		for (int i = 0; i < 10; i++)
+		{
+			uint64_t p_0 = static_cast<uint64_t>(0xD2511F53u)*c_0;
+			uint64_t p_1 = static_cast<uint64_t>(0xCD9E8D57u)*c_2;
+			c_0 = static_cast<uint32_t>(p_1 >> 32) ^ c_1 ^ k_0; c_1 = static_cast<uint32_t>(p_1);
+			c_2 = static_cast<uint32_t>(p_0 >> 32) ^ c_3 ^ k_1; c_3 = static_cast<uint32_t>(p_0);
+			k_0 += 0x9E3779B9u; k_1 += 0xBB67AE85u;
+		}
+		return { c_0, c_1, c_2, c_3 };
+	}
+
+	//two independent uniform numbers in [0, 1) with 53 random bits each
+	static Vec2 uniform2(uint64_t key, uint32_t stream, uint32_t id, uint32_t step, uint32_t draw = 0)
+	{
+		std::array<uint32_t, 4> c = block(key, id, step, stream, draw);
+		uint64_t a = (static_cast<uint64_t>(c[0]) << 32 | c[1]) >> 11;
+		uint64_t b = (static_cast<uint64_t>(c[2]) << 32 | c[3]) >> 11;
+		return Vec2(a*0x1.0p-53, b*0x1.0p-53);
+	}
+	static double uniform(uint64_t key, uint32_t stream, uint32_t id, uint32_t step, uint32_t draw = 0) { return uniform2(key, stream, id, step, draw).x(); }
+
+	//two independent standard normal numbers, by Box-Muller
+	static Vec2 normal2(uint64_t key, uint32_t stream, uint32_t id, uint32_t step, uint32_t draw = 0)
+	{
+		Vec2 u = uniform2(key, stream, id, step, draw);
+		double r = std::sqrt(-2*std::log(1 - u.x())); 		//1 - u is in (0, 1] so the log is finite
+		double a = 2*M_PI*u.y();
+		return Vec2(r*std::cos(a), r*std::sin(a));
+	}
+};
+
+#endif // PHILOX_H
@@ -0,0 +1,108 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <vector>
+#include <memory>
+#include <new>
+#include <utility>
+
+//growable object storage with stable addresses
+//objects live in fixed size chunks so pointers handed out are never invalidated by growth,
+//released slots are retired and only handed out again after recycle() so pointers stay safe for the current step
+//live objects are also kept in a dense list, updated in O(1) by swap-remove, so iteration never touches dead slots
+template <typename T, int CHUNK_BITS = 10>
+class Slab
+{
+private:
+
+	static constexpr int CHUNK_SIZE = 1 << CHUNK_BITS;
+
+	std::vector<std::unique_ptr<T[]>> chunks_;
+	std::vector<T*> live_;			//dense list of live objects
+	std::vector<int> live_slot_;	//slot of each entry in live_
+	std::vector<int> live_i_;		//position of each slot in live_, -1 if dead
+	std::vector<int> free_;			//released slots ready to be reused
+	std::vector<int> retired_;		//released slots waiting for recycle()
+	int size_;						//number of slots ever handed out
+
+public:
+
+	Slab() : size_(0) {}
+	Slab(const Slab&) = delete;
+	Slab& operator=(const Slab&) = delete;
+
+	T& operator[](int i) 			{ return chunks_[i >> CHUNK_BITS][i & (CHUNK_SIZE-1)]; }
+	const T& operator[](int i) const 	{ return chunks_[i >> CHUNK_BITS][i & (CHUNK_SIZE-1)]; }
+
+	const bool alive(int i) const { return live_i_[i] >= 0; }
+	const int position(int i) const { return live_i_[i]; }
+	const int size() const { return size_; }
+	const int count() const { return live_.size(); }
+	const std::vector<T*>& live() const { return live_; }
+
+	int allocate()
+	{
+		int i;
+		if (!free_.empty()) { i = free_.back(); free_.pop_back(); }
+		else
+		{
+			i = size_++;
+			if ((i >> CHUNK_BITS) == static_cast<int>(chunks_.size())) chunks_.emplace_back(new T[CHUNK_SIZE]);
+			live_i_.push_back(-1);
+		}
+		live_i_[i] = live_.size();
+		live_.push_back(&(*this)[i]);
+		live_slot_.push_back(i);
+		return i;
+	}
+
+	template <typename... Args>
+	T* construct(int i, Args&&... args) 		//build object in place so it can hold pointers to itself
+	{
+		T* p = &(*this)[i];
+		p->~T();
+		return new (p) T(std::forward<Args>(args)...);
+	}
+
+	void release(int i)
+	{
+		int p = live_i_[i];
+		if (p < 0) return;
+		int last = live_slot_.back();						//move last live entry into the gap
+		live_[p] = live_.back(); live_slot_[p] = last; live_i_[last] = p;
+		live_.pop_back(); live_slot_.pop_back();
+		live_i_[i] = -1;
+		retired_.push_back(i);
+	}
+
+	void recycle()
+	{
+		free_.insert(free_.end(), retired_.begin(), retired_.end());
+		retired_.clear();
+	}
+
+	const std::vector<int>& liveSlots() const { return live_slot_; }
+	std::vector<int> freeSlots() const 		//in the order they will be handed out after the next recycle()
+	{
+		std::vector<int> slots(free_);
+		slots.insert(slots.end(), retired_.begin(), retired_.end());
+		return slots;
+	}
+
+	void restore(int size, const std::vector<int>& live_slots, const std::vector<int>& free_slots) 	//slot layout of a checkpoint, objects are then filled in by the caller
+	{
+		chunks_.clear(); live_.clear(); live_slot_.clear(); retired_.clear();
+		size_ = size;
+		while ((static_cast<int>(chunks_.size()) << CHUNK_BITS) < size) chunks_.emplace_back(new T[CHUNK_SIZE]);
+		live_i_.assign(size, -1);
+		for (int i : live_slots)
+		{
+			live_i_[i] = live_.size();
+			live_.push_back(&(*this)[i]);
+			live_slot_.push_back(i);
+		}
+		free_ = free_slots;
+	}
+};
+
+#endif // SLAB_H
@@ -0,0 +1,86 @@
+#ifndef SMALL_SET_H
+#define SMALL_SET_H
+
+#include <algorithm>
+
+
+//set of a few trivially copyable values (pointers) stored inline in insertion order
+//only spills to the heap if more than N values are held, which is rare for vertex and edge contacts
+template <typename T, int N>
+class SmallSet
+{
+private:
+
+	T inline_[N];
+	T* heap_; 				//overflow storage, nullptr until more than N values are held
+	int size_;
+	int capacity_;
+	
+	T* data() 				{ return heap_ ? heap_ : inline_; }
+	const T* data() const 	{ return heap_ ? heap_ : inline_; }
+	
+	void reserve(int capacity)
+	{
+		if (capacity <= capacity_) return;
+		T* heap = new T[capacity];
+		std::copy(data(), data()+size_, heap);
+		delete[] heap_;
+		heap_ = heap; capacity_ = capacity;
+	}
+
+public:
+
+	SmallSet() : heap_(nullptr), size_(0), capacity_(N) {}
+	SmallSet(const SmallSet& other) : heap_(nullptr), size_(0), capacity_(N) { *this = other; }
+	SmallSet(SmallSet&& other) noexcept : heap_(nullptr), size_(0), capacity_(N) { *this = std::move(other); }
+	~SmallSet() { delete[] heap_; }
+	
+	SmallSet& operator=(const SmallSet& other)
+	{
+		if (this == &other) return *this;
+		size_ = 0;
+		reserve(other.size_);
+		std::copy(other.begin(), other.end(), data());
+		size_ = other.size_;
+		return *this;
+	}
+	SmallSet& operator=(SmallSet&& other) noexcept
+	{
+		if (this == &other) return *this;
+		delete[] heap_;
+		std::copy(other.inline_, other.inline_+N, inline_);
+		heap_ = other.heap_; size_ = other.size_; capacity_ = other.capacity_;
+		other.heap_ = nullptr; other.size_ = 0; other.capacity_ = N;
+		return *this;
+	}
+	
+	const T* begin() const 	{ return data(); }
+	const T* end() const 	{ return data()+size_; }
+	const size_t size() const { return size_; }
+	const bool empty() const { return size_ == 0; }
+	
+	const size_t count(T x) const { return std::find(begin(), end(), x) != end(); }
+	
+	bool insert(T x)
+	{
+		if (count(x)) return false;
+		if (size_ == capacity_) reserve(2*capacity_);
+		data()[size_++] = x;
+		return true;
+	}
+	template <typename It>
+	void insert(It first, It last) { for (; first != last; first++) insert(*first); }
+	
+	size_t erase(T x)
+	{
+		T* it = std::find(data(), data()+size_, x);
+		if (it == data()+size_) return 0;
+		std::copy(it+1, data()+size_, it);
+		size_--;
+		return 1;
+	}
+	
+	void clear() { size_ = 0; }
+};
+
+#endif // SMALL_SET_H
@@ -0,0 +1,68 @@
+#ifndef SNAPSHOT_WRITER_H
+#define SNAPSHOT_WRITER_H
+
+#include <vector>
+#include <array>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+
+//polygons as flat arrays ready to be written out
+struct Polygons
+{
+	std::vector<float> points; 			//x, y, z of each point
+	std::vector<int32_t> connectivity; 	//point indices of every polygon, one after the other
+	std::vector<int32_t> offsets; 		//end of each polygon in connectivity
+
+	void clear() { points.clear(); connectivity.clear(); offsets.clear(); }
+};
+
+//compact copy of everything written in one snapshot, buffers keep their capacity between uses
+struct Frame
+{
+	std::string title;
+	int timestep;
+	bool binary;
+
+	Polygons cells;
+	std::vector<float> directors; 				//two points per cell
+	std::array<Polygons, 4> c_def; 				//PLUSHALF, PLUSONE, MINUSHALF, MINUSONE
+	std::array<std::vector<float>, 4> v_def;
+};
+
+//background thread writing snapshots so the timestep loop does not wait for the disk
+//a fixed number of frames is cycled between the simulation and the writer, when all are queued acquire() blocks
+class SnapshotWriter
+{
+private:
+
+	std::vector<std::unique_ptr<Frame>> frames_;
+	std::deque<Frame*> free_; 			//frames ready to be filled
+	std::deque<Frame*> queued_; 		//frames waiting to be written
+	bool writing_;
+	bool stop_;
+
+	std::mutex mutex_;
+	std::condition_variable changed_;
+	std::thread thread_;
+
+	void work();
+
+public:
+
+	SnapshotWriter(int buffers);
+	~SnapshotWriter();
+	SnapshotWriter(const SnapshotWriter&) = delete;
+	SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+	Frame* acquire(); 				//empty frame to fill, waits while every frame is queued or being written
+	void submit(Frame* frame); 		//hand a filled frame to the writer thread
+	void flush(); 					//wait until every submitted frame is on disk
+};
+
+#endif // SNAPSHOT_WRITER_H
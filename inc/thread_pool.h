@@ -0,0 +1,96 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+
+//persistent pool of worker threads for the data parallel phases of a timestep
+//work is split into contiguous blocks, one per thread, and every entity is updated by exactly one thread
+//so results do not depend on the number of threads
+class ThreadPool
+{
+private:
+
+	std::vector<std::thread> workers_;
+	std::mutex mutex_;
+	std::condition_variable start_;
+	
+	const std::function<void(int)>* job_;
+	std::atomic<int> generation_; 		//incremented every time a job is handed out
+	std::atomic<int> pending_; 			//workers still busy with the current job
+	std::atomic<bool> stop_;
+	
+	void work(int t);
+
+public:
+
+	ThreadPool(int n_threads);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	
+	const int size() const;
+	
+	void run(const std::function<void(int)>& job); 	//call job(t) for t in [0, size()), caller runs t = 0
+	
+	template <typename T, typename F>
+	void forEach(const std::vector<T*>& items, F f)
+	{
+		long n = items.size(); int k = size();
+		if (k == 1 || n < 64*k) { for (T* x : items) f(x); return; }
+		run([&items, &f, n, k](int t)
+		{
+			for (long i = n*t/k; i < n*(t+1)/k; i++) f(items[i]);
+		});
+	}
+	
+	template <typename F>
+	void forEachIndex(long n, F f) 		//f(i) for i in [0, n), for work already grouped into blocks
+	{
+		int k = size();
+		if (k == 1 || n < 8*k) { for (long i = 0; i < n; i++) f(i); return; }
+		run([&f, n, k](int t)
+		{
+			for (long i = n*t/k; i < n*(t+1)/k; i++) f(i);
+		});
+	}
+	
+	template <typename T, typename F, typename R>
+	double reduce(const std::vector<T*>& items, double init, F f, R r) 	//combine f(x) of all items with r, r must not depend on order e.g. min or max
+	{
+		long n = items.size(); int k = size();
+		double y = init;
+		if (k == 1 || n < 64*k) { for (T* x : items) y = r(y, f(x)); return y; }
+		std::vector<double> partial(k, init);
+		run([&items, &f, &r, &partial, n, k](int t)
+		{
+			double y_t = partial[t];
+			for (long i = n*t/k; i < n*(t+1)/k; i++) y_t = r(y_t, f(items[i]));
+			partial[t] = y_t;
+		});
+		for (double y_t : partial) y = r(y, y_t);
+		return y;
+	}
+	
+	template <typename T, typename F>
+	std::vector<T*> filter(const std::vector<T*>& items, F f) 	//items for which f(x) is true, in their order in items, f may also update x
+	{
+		long n = items.size(); int k = size();
+		std::vector<T*> out;
+		if (k == 1 || n < 64*k) { for (T* x : items) if (f(x)) out.push_back(x); return out; }
+		std::vector<std::vector<T*>> partial(k);
+		run([&items, &f, &partial, n, k](int t)
+		{
+			for (long i = n*t/k; i < n*(t+1)/k; i++) if (f(items[i])) partial[t].push_back(items[i]);
+		});
+		for (const std::vector<T*>& out_t : partial) out.insert(out.end(), out_t.begin(), out_t.end());
+		return out;
+	}
+};
+
+#endif // THREAD_POOL_H
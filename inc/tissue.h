@@ -3,8 +3,20 @@
 
 #include <unordered_map>
 #include <array>
+#include <memory>
+#include <string>
+#include <stdexcept>
 
-#include "libraries.h"
+#include "vec2.h"
+#include "voronoi.h"
+#include "slab.h"
+#include "thread_pool.h"
+#include "snapshot_writer.h"
+#include "checkpoint.h"
+#include "philox.h"
+#include "defect_recorder.h"
+#include "metrics_recorder.h"
+#include "cell_geometry.h"
 #include "vertex.h"
 #include "edge.h"
 #include "cell.h"
@@ -12,24 +24,25 @@
 #include "parameters.h"
 #include "functions.h"
 
-#define V_ARR_SIZE 6000
-#define E_ARR_SIZE 9000
-#define C_ARR_SIZE 3000
+struct StandardModel;
 
 class Tissue
 {
 private:
 
-	std::array<Vertex, V_ARR_SIZE> v_arr;
-	std::array<Edge, E_ARR_SIZE> e_arr;
-	std::array<Cell, C_ARR_SIZE> c_arr;
-	std::array<bool, V_ARR_SIZE> v_in;
-	std::array<bool, E_ARR_SIZE> e_in;
-	std::array<bool, C_ARR_SIZE> c_in;
+	Slab<Vertex> v_arr;
+	Slab<Edge> e_arr;
+	Slab<Cell> c_arr;
 	
-	Vertex* v_0_; Vertex* v_c_;
-	Edge* e_0_; Edge* e_c_;
-	Cell* c_0_; Cell* c_c_;
+	Parameters param_;
+	std::unique_ptr<ThreadPool> pool_;
+	CellGeometry geometry_;
+	bool edge_forces_; 		//assemble forces per edge instead of per vertex
+	int snapshot_interval_; //timesteps between vtk snapshots, 0 for none
+	bool binary_output_; 	//write snapshots as binary VTK XML instead of legacy ASCII
+	int checkpoint_interval_; 	//timesteps between checkpoints, 0 for none
+	bool adaptive_; 		//choose each time step from how fast edges change
+	std::unique_ptr<SnapshotWriter> writer_;
 	
 	std::vector<Cell*> c_def_PLUSHALF_;
 	std::vector<Cell*> c_def_PLUSONE_;
@@ -40,36 +53,83 @@ private:
 	std::vector<Vertex*> v_def_MINUSHALF_;
 	std::vector<Vertex*> v_def_MINUSONE_;
 	
-	std::array<unsigned short, 100000> def_PLUSHALF_c;
-	std::array<unsigned short, 100000> def_PLUSONE_c;
-	std::array<unsigned short, 100000> def_MINUSHALF_c;
-	std::array<unsigned short, 100000> def_MINUSONE_c;
-	
+	int defect_interval_; 		//timesteps between defect count samples, 0 for none
+	int defect_decimation_; 	//samples averaged into each recorded row
+	bool binary_defects_;
+	std::unique_ptr<DefectRecorder> defects_; 		//opened by the first run() that records
+	DefectRecorder::State defect_resume_; 			//where a restored run continues the defect file
+	int metrics_interval_; 		//timesteps between rows of the metrics file, 0 for none
+	bool metrics_json_;
+	std::unique_ptr<MetricsRecorder> metrics_; 		//phases are only timed while this is open
+	uint64_t metrics_resume_; 						//length of the metrics file a restored run truncates it to
 	
 	int timestep;
+	double time_; 			//simulated time
+	bool running_; 			//inside run(), a checkpoint written now continues the run when it is restored
+	bool resumed_; 			//restored from such a checkpoint, so the next run() carries on with the saved boundary flags
+	
+	//T1 candidates, every edge not in short_watch_ is longer than l_min until vertices have moved a total of t1_skin
+	std::vector<Edge*> short_watch_;
+	std::vector<char> e_watched_; 			//by edge id, whether the edge is in short_watch_
+	double moved_; 							//bound on how much any edge length has changed since short_watch_ was built
+	double step_moved_; 					//part of moved_ from the last timestep
+	std::vector<Vertex*> fourfold_watch_; 	//vertices that have had four edges since they were last checked
+	std::vector<char> v_watched_;
+	std::vector<int> c_mark_; 				//by cell id, epoch of the last mark, shared by T1 and transitions
+	int epoch_;
+	TopologyEvents events_;
 	
-	void extrusion();
-	void division();
+	void recycle();
+	void extrusion(const std::vector<Cell*>& small_cells, std::vector<Cell*>& large_cells);
+	void division(const std::vector<Cell*>& large_cells);
 	void transitions();
 	void T1();
 	void findDefects();
-	void countDefects();
+	void writeSnapshot(const std::string& title);
+	template <typename Model> double adaptiveStep();
+	void rebuildShortWatch();
+	const bool mark(Cell* c) const; 			//whether c is marked in the current epoch
 	
 public:
 
-	Tissue(VD& vd, bool (*in)(const Point&));
+	Tissue(const CellMesh& mesh, bool (*in)(const Point&), int n_threads = 1); 	//cells with a vertex outside in are dropped, threads as in setThreads() also share the setup
+	Tissue(const std::string& checkpoint); 			//restore from writeCheckpoint(), run options are not restored
 	~Tissue();
+	Tissue(const Tissue&) = delete;
+	Tissue& operator=(const Tissue&) = delete;
+	
+	void setThreads(int n_threads);
+	const int threads() const;
+	void setEdgeForces(bool edge_forces);
+	void setParameters(const Parameters& param);
+	const Parameters& param() const;
+	void setSnapshots(int interval, bool binary, int buffers); 		//buffers bounds the snapshots queued for the writer thread
+	void setAdaptive(bool adaptive);
+	const double time() const;
+	const TopologyEvents& events() const;
+	void setCheckpoints(int interval); 			//written to title + "checkpoint.bin" during run()
+	void setDefectRecording(int interval, int decimation, bool binary); 	//streamed to title + "defects.txt" or ".bin" during run()
+	void setMetrics(int interval, bool json); 		//phase timings and event counts streamed to title + "metrics.csv" or ".json" during run()
+	void writeCheckpoint(const std::string& filename) const;
 	
 	const bool v_alive(Vertex* v) const;
+	const int v_index(Vertex* v) const; 			//position of vertex in vertices()
     
-    std::vector<Vertex*> vertices();
-	std::vector<Edge*> edges();
-    std::vector<Cell*> cells();	
+    const std::vector<Vertex*>& vertices() const;
+	const std::vector<Edge*>& edges() const;
+    const std::vector<Cell*>& cells() const;
+    
+    Vertex* const v_at(int id); 					//object by id, nullptr for -1
+    Edge* const e_at(int id);
+    Cell* const c_at(int id);
+    HalfEdge* const h_at(int id); 					//half-edge i of edge e has id 2*e->id()+i
+    const int h_id(const HalfEdge* h) const;
+    
+    void watchEdge(Edge* e); 						//edge length changed other than by the timestep, check it for T1s
+    void watchVertex(Vertex* v); 					//vertex moved other than by the timestep
+    void watchFourfold(Vertex* v); 				//vertex may need a T1 split
+    void watchLoop(Cell* c); 						//corners of c changed other than through the tissue
     
-    Vertex* const v_c() const; Vertex* const v_0() const;
-    Edge* const e_c() const; Edge* const e_0() const;
-    Cell* const c_c() const; Cell* const c_0() const;
-
 	const std::vector<Cell*>& c_def_PLUSHALF() const;
 	const std::vector<Cell*>& c_def_PLUSONE() const;
 	const std::vector<Cell*>& c_def_MINUSHALF() const;
@@ -82,21 +142,29 @@ public:
 	Vertex* const createVertex(Point r);
 	Edge* const createEdge(Vertex* v_1, Vertex* v_2);
 	Cell* const createCell(std::vector<Vertex*>& vertices, std::vector<Edge*>& edges);
+	Cell* const createCell(HalfEdge* h); 			//cell from an already linked half-edge loop
 	
 	void destroyVertex(Vertex* v);
-	void destroyEdge(Edge* e);
+	void destroyEdge(Edge* e); 						//edge must not bound any cell
 	void destroyCell(Cell* c);
-		
-	void cellNewVertex(Cell* c, Vertex* v, int i); 	//add new vertex to cell vertices at index i
-	void cellRemoveVertex(Cell* c, Vertex* v);
-	void cellExchangeVertex(Cell* c, Vertex* v_old, Vertex* v_new);
 	
-	void cellNewEdge(Cell* c, Edge* e, int i); 		//add new edge to cell edges at index i
-	int cellRemoveEdge(Cell* c, Edge* e);
+	void unlink(HalfEdge* h); 						//remove half-edge from its cell's loop
+	void insertAfter(HalfEdge* h_prev, HalfEdge* h); 	//add half-edge to the loop of h_prev's cell after h_prev
+	Vertex* const splitEdge(Edge* e, Point r); 		//add vertex at r along edge, splitting it in two
+	Cell* const splitCell(Cell* c, HalfEdge* h_1, HalfEdge* h_2); 	//join origins of two half-edges of c, returns the cell starting at h_2
+	
+	//random numbers fixed by the seed, a stream from philox.h, the entity id, the current timestep and a draw index,
+	//so stochastic terms do not depend on the thread count or the order entities are visited in
+	const double uniform(int stream, int id, int draw = 0) const; 		//in [0, 1)
+	const Vec normal(int stream, int id, int draw = 0) const; 			//two independent standard normal numbers
 	
-	const double D_angle(Cell* c_i, Cell* c_j) const; 
+	const double winding(const std::vector<Cell*>& loop, const std::vector<Edge*>& between) const; 	//turns of (Z, X) round a loop of cells, between[i] joins loop[i] and loop[i+1]
 	
-	void run(int max_timestep, std::string title);
+	template <typename Model = StandardModel> void run(int max_timestep, std::string title); 	//compiled for every model in model.h
+	//one phase of a timestep as run() does it, a PHASE_ from metrics_recorder.h other than PHASE_OUTPUT, so phases can be
+	//timed one at a time, a phase reads what the phases before it in the step have written
+	template <typename Model = StandardModel> void runPhase(int phase);
+	const std::array<int, 4> countDefects() const; 	//PLUSHALF, PLUSONE, MINUSHALF, MINUSONE
 	
 };
 
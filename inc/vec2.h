@@ -0,0 +1,51 @@
+#ifndef VEC2_H
+#define VEC2_H
+
+#include <ostream>
+
+//plain pair of doubles used for positions and vectors throughout the model, trivially copyable so arrays of them
+//can be copied as raw bytes and kept in registers, aligned so both coordinates load and store together
+struct alignas(16) Vec2
+{
+private:
+
+	double x_;
+	double y_;
+
+public:
+
+	Vec2() = default;
+	constexpr Vec2(double x, double y) : x_(x), y_(y) {}
+
+	constexpr double x() const { return x_; }
+	constexpr double y() const { return y_; }
+	constexpr double squared_length() const { return x_*x_ + y_*y_; }
+
+	constexpr Vec2 operator+(const Vec2& u) const { return Vec2(x_ + u.x_, y_ + u.y_); }
+	constexpr Vec2 operator-(const Vec2& u) const { return Vec2(x_ - u.x_, y_ - u.y_); }
+	constexpr Vec2 operator-() const { return Vec2(-x_, -y_); }
+	constexpr Vec2 operator/(double s) const { return Vec2(x_/s, y_/s); }
+	constexpr double operator*(const Vec2& u) const { return x_*u.x_ + y_*u.y_; } 	//dot product
+
+	Vec2& operator+=(const Vec2& u) { x_ += u.x_; y_ += u.y_; return *this; }
+	Vec2& operator-=(const Vec2& u) { x_ -= u.x_; y_ -= u.y_; return *this; }
+	Vec2& operator*=(double s) { x_ *= s; y_ *= s; return *this; }
+	Vec2& operator/=(double s) { x_ /= s; y_ /= s; return *this; }
+
+	constexpr bool operator==(const Vec2& u) const { return x_ == u.x_ && y_ == u.y_; }
+	constexpr bool operator!=(const Vec2& u) const { return !(*this == u); }
+};
+
+constexpr Vec2 operator*(double s, const Vec2& u) { return Vec2(s*u.x(), s*u.y()); }
+constexpr Vec2 operator*(const Vec2& u, double s) { return Vec2(s*u.x(), s*u.y()); }
+
+constexpr Vec2 midpoint(const Vec2& a, const Vec2& b) { return Vec2((a.x() + b.x())/2, (a.y() + b.y())/2); }
+constexpr double squared_distance(const Vec2& a, const Vec2& b) { return (a - b).squared_length(); }
+
+inline std::ostream& operator<<(std::ostream& out, const Vec2& u) { return out << u.x() << ' ' << u.y(); }
+
+//positions and displacements share the type, the names only document intent
+typedef Vec2 Point;
+typedef Vec2 Vec;
+
+#endif // VEC2_H
@@ -9,7 +9,10 @@
 #include <iostream>
 
 #include "parameters.h"
-#include "libraries.h"
+#include "vec2.h"
+#include "small_set.h"
+#include "halfedge.h"
+#include "checkpoint.h"
 
 class Tissue;
 
@@ -22,30 +25,38 @@ class Vertex
 private:
 
 	Tissue* T;
+	int id_;
     Point r_;
     Vec force_;
     double m_;
     int not_boundary_cell;
     
-    std::unordered_set<Edge*> edge_contacts_;
-    std::unordered_set<Cell*> cell_contacts_;
+    SmallSet<Edge*, 4> edge_contacts_;
+    SmallSet<Cell*, 4> cell_contacts_;
     
-	std::vector<std::pair<Cell*, double>> cell_contacts_ordered;
+	std::vector<Cell*> cell_contacts_ordered; 		//anticlockwise, open fans at the boundary start from one end
+	std::vector<Edge*> contact_edges_; 				//edge between each ordered contact and the next, nullptr across a gap
     
     Vec calcSurfaceForce();
     Vec calcLineForce();
 
 public:
     
-    Vertex(Tissue* T, Point r);
+    Vertex(Tissue* T, int id, Point r);
     Vertex();
     bool operator==(const Vertex& other) const;
     bool onBoundaryCell();
     
+    const int id() const;
     const Point& r() const;
     const double m() const;
-    const std::unordered_set<Cell*>& cellContacts() const;
-    const std::unordered_set<Edge*>& edgeContacts() const;
+    const SmallSet<Cell*, 4>& cellContacts() const;
+    const SmallSet<Edge*, 4>& edgeContacts() const;
+    const std::vector<Cell*>& orderedCellContacts() const;
+    const std::vector<Edge*>& contactEdges() const; 	//edge between each ordered contact and the next
+    HalfEdge* const out(Cell* c); 	//half-edge of cell c starting at vertex
+    
+    void setR(const Point& r);
 
     void addCellContact(Cell* c);
     void removeCellContact(Cell* c);
@@ -54,13 +65,18 @@ public:
     void removeEdgeContact(Edge* e);
 
     void calcForce();
-    void applyForce();
+    void gatherForce();
+    template <typename Model> const Vec velocity(const Parameters& p) const; 		//kernels templated on the model are defined in model.h
+    template <typename Model> const double applyForce(const Parameters& p, double dt); 		//returns the squared distance moved
     void shearForce();
 
 	void orderCellContacts();
-	void T1split();
+	const bool T1split(); 		//whether the vertex was split
 	void calcm();
 	
+	void save(CheckpointOut& out) const;
+	void load(CheckpointIn& in, Tissue* tissue, int id); 	//cells and edges are looked up by id in tissue, derived values are left to the caller
+	
 };
 
 #endif // VERTEX_H
@@ -0,0 +1,21 @@
+#ifndef VORONOI_H
+#define VORONOI_H
+
+#include <vector>
+
+#include "vec2.h"
+
+//cell polygons that share vertices by index, what a Tissue is built from
+//faces list vertex indices in the order they are joined, vertices belonging to no face are kept so ids stay stable
+struct CellMesh
+{
+	std::vector<Point> vertices;
+	std::vector<std::vector<int>> faces;
+};
+
+//bounded cells of the voronoi diagram of the seeds, the only place CGAL is needed
+//they are read straight off the delaunay triangulation without building a VD, so large seed sets start quickly
+//diagrams that are already built can be converted with voronoiCells(const VD&) from libraries.h
+CellMesh voronoiCells(const std::vector<Point>& seeds);
+
+#endif // VORONOI_H
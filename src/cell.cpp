@@ -2,25 +2,24 @@
 #include "tissue.h"
 
 
-Cell::Cell(Tissue* T, std::vector<Vertex*>& vertices_, std::vector<Edge*>& edges_) : 
-	T(T), vertices_(vertices_), edges_(edges_)
+Cell::Cell(Tissue* T, int id, HalfEdge* h) : 
+	T(T), id_(id), h_(h)
 {	
-	vertices_.reserve(8);
-	edges_.reserve(8);
 	neighbours_.reserve(8);
 	
 	A_ = 0;
-	size_t n = vertices_.size();
-	for (int i = 0; i < n; i++)
+	for (HalfEdge* h : halfEdges())
 	{
-		Point r_i = vertices_[i]->r();
-		Point r_j = vertices_[(i+1)%n]->r();
+		h->c = this;
+		const Point& r_i = h->v->r();
+		const Point& r_j = h->next->v->r();
 		A_ += r_i.x()*r_j.y() - r_j.x()*r_i.y();
 	} A_*= 0.5; S_ = A_/std::fabs(A_);
 }
 Cell::Cell() = default;
 
 
+const int 		Cell::id() 	const { return id_; }
 const Point& 	Cell::r_0() const { return r_0_; }
 const double 	Cell::A() 	const { return S_*A_; }
 const double 	Cell::S() 	const { return S_; }
@@ -29,281 +28,154 @@ const double 	Cell::T_A() const { return T_A_; }
 const Vec& 	 	Cell::n() 	const { return n_; }
 const double 	Cell::Z() 	const { return Z_; }
 const double 	Cell::X() 	const { return X_; }
+const double 	Cell::Zn() 	const { return Zn_; }
+const double 	Cell::Xn() 	const { return Xn_; }
 const double 	Cell::m() 	const { return m_; }
 
-const std::vector<Vertex*>& Cell::vertices() 	const { return vertices_; }
-const std::vector<Edge*>& Cell::edges()			const { return edges_; }
-const std::vector<Cell*>& Cell::neighbours()	const { return neighbours_; }
-
-
-void Cell::addVertex(Vertex* v, int i) { vertices_.insert(vertices_.begin()+i, v); }
-void Cell::removeVertex(Vertex* v) 
-{ 
-	std::vector<Vertex*>::const_iterator it = std::find(vertices_.begin(), vertices_.end(), v);
-	if (it != vertices_.end())
-	{
-		vertices_.erase(it); 
-		v->removeCellContact(this);
-	}
-	
-}
-void Cell::exchangeVertex(Vertex* v_old, Vertex* v_new)
-{	
-	std::vector<Vertex*>::iterator it_new = std::find(vertices_.begin(), vertices_.end(), v_new);
-	if (it_new == vertices_.end()) 
-	{ 
-		std::vector<Vertex*>::iterator it_old = std::find(vertices_.begin(), vertices_.end(), v_old);
-		if (it_old != vertices_.end())
-		{
-			*it_old = v_new;
-			v_new->addCellContact(this);
-		}
-	}
-	removeVertex(v_old);
+HalfEdge* const Cell::h() const { return h_; }
+const HalfEdgeLoop Cell::halfEdges() const { return HalfEdgeLoop(h_); }
+const int Cell::size() const
+{
+	int n = 0; HalfEdge* h = h_;
+	do { n++; h = h->next; } while (h != h_);
+	return n;
 }
-void Cell::rotateVertices() { std::rotate(vertices_.rbegin(), vertices_.rbegin() + 1, vertices_.rend());}
+const std::vector<Cell*>& Cell::neighbours()	const { return neighbours_; }
 
-void Cell::addEdge(Edge* e, int i) { edges_.insert(edges_.begin()+i, e); }
-int Cell::removeEdge(Edge* e) 
-{ 
-	std::vector<Edge*>::const_iterator it = std::find(edges_.begin(), edges_.end(), e);
-	if (it != edges_.end())
-	{
-		edges_.erase(it); 
-		e->removeCellJunction(this);
-	}
-	return std::distance(edges_.cbegin(), it);
-}
+void Cell::setH(HalfEdge* h) { h_ = h; }
 
 
-const bool Cell::hasEdge(Edge* e) const
-{
-	std::vector<Edge*>::const_iterator it = std::find(edges_.begin(), edges_.end(), e);
-	return it != edges_.end();
-}
+const bool Cell::hasEdge(Edge* e) const { return e->h(0)->c == this || e->h(1)->c == this; }
 const bool Cell::onBoundary() const
 {
-	for (Edge* e : edges_) { if (e->cellJunctions().size() < 2) return true; }
+	for (HalfEdge* h : halfEdges()) { if (h->twin->c == nullptr) return true; }
 	return false;
 }
 
 void Cell::findNeighbours()
 {
-	neighbours_ = {};
-	std::unordered_set<Cell*> seen_cells;
-	std::vector<std::pair<Cell*, double>> neighbour_cells_vec;
-
-	for (Vertex* v : vertices_) 
+	//going anticlockwise round the cell, the cells after this one round each vertex are the next neighbours
+	//so vertex orders must already be up to date
+	//neighbours that follow each other round a vertex are joined by the edge between them there
+	neighbours_.clear(); neighbour_edges_.clear();
+	std::vector<Vertex*> corners;
+	for (HalfEdge* h : halfEdges()) corners.push_back(h->v);
+	if (S_ < 0) std::reverse(corners.begin(), corners.end());
+	
+	Edge* e_wrap = nullptr; 		//joins the last neighbour to the first
+	for (Vertex* v : corners)
 	{
-		for (Cell* c : v->cellContacts()) 
+		const std::vector<Cell*>& around = v->orderedCellContacts();
+		const std::vector<Edge*>& joins = v->contactEdges();
+		size_t n = around.size();
+		size_t i = std::find(around.begin(), around.end(), this) - around.begin();
+		for (size_t k = 1; k < n; k++)
 		{
-			if (c == this || !seen_cells.insert(c).second) continue;
-			c->calcR_0();
-			Vec vec = c->r_0() - r_0_;
-			double theta = std::atan2(vec.y(), vec.x());
-			neighbour_cells_vec.push_back({c, theta});
+			Cell* c = around[(i+k)%n];
+			Edge* e = (!neighbours_.empty() && around[(i+k-1)%n] == neighbours_.back()) ? joins[(i+k-1)%n] : nullptr;
+			if (std::find(neighbours_.begin(), neighbours_.end(), c) == neighbours_.end())
+			{
+				if (!neighbours_.empty()) neighbour_edges_.push_back(e);
+				neighbours_.push_back(c);
+			}
+			else if (c == neighbours_.front()) e_wrap = e;
 		}
 	}
-
-	std::sort(neighbour_cells_vec.begin(), neighbour_cells_vec.end(), 
-		[](const std::pair<Cell*, double>& c1, const std::pair<Cell*, double>& c2) { return c1.second < c2.second; });
-
-	for (const std::pair<Cell*, double>& ce : neighbour_cells_vec) neighbours_.push_back(ce.first);
+	if (!neighbours_.empty()) neighbour_edges_.push_back(e_wrap);
 }
 
-const int Cell::longestEdge_i() const
+HalfEdge* const Cell::longestEdge() const
 {
-	double longest_l = 0; int i_l;
-	for (int i= 0; i < edges_.size(); i++) 
+	double longest_l = 0; HalfEdge* h_l = h_;
+	for (HalfEdge* h : halfEdges()) 
 	{
-		if (edges_[i]->l() > longest_l) 
+		if (h->e->l() > longest_l) 
 		{
-			longest_l = edges_[i]->l();
-			i_l = i;
+			longest_l = h->e->l();
+			h_l = h;
 		}
-	} return i_l;
+	} return h_l;
 }
 
 
-void Cell::extrude()
+const bool Cell::extrude()
 {
+	std::vector<HalfEdge*> loop;
+	for (HalfEdge* h : halfEdges()) loop.push_back(h);
 	
 	//simply destroy cell if it is on a boundary
 	if (onBoundary()) 
 	{ 
 		std::vector<Cell*> neighbours_copy = neighbours_;
-		std::vector<Vertex*> vertices_copy = vertices_;
+		std::vector<Vertex*> vertices_copy;
+		for (HalfEdge* h : loop) vertices_copy.push_back(h->v);
 		T->destroyCell(this);
-		//update neighbours and contacts orders
-		for (Cell* c : neighbours_copy) c->findNeighbours();
+		//update contacts orders and neighbours
 		for (Vertex* v : vertices_copy) if (T->v_alive(v)) v->orderCellContacts();
-		return; 
+		for (Cell* c : neighbours_copy) c->findNeighbours();
+		return true; 
 	}
-	for (Vertex* v : vertices_) { if (v->edgeContacts().size() > 3) return; }
+	for (HalfEdge* h : loop) { if (h->v->edgeContacts().size() > 3) return false; }
 	
-	calcR_0(); 													//calculate centroid, create vertex at centroid, and detatch cell vertices and edges from cell
+	calcR_0(); 													//calculate centroid and create vertex at centroid
 	Vertex* v_new = T->createVertex(r_0_);
-	for (Vertex* v : vertices_) { v->removeCellContact(this); }
-	for (Edge* e : edges_) { e->removeCellJunction(this); }
-
-	for (Edge* e : edges_)
-	{	
-		Cell* c = *(e->cellJunctions().begin()); 				//cell outside edge
-		
-		//tell vertices that it is no longer in contact with the removed edges
-		e->v1()->removeEdgeContact(e);
-		e->v2()->removeEdgeContact(e);
 	
-		c->removeEdge(e);										//disconnect edge from outside cell, edge will delete itself because it has no cell junctions	
-	}
-	for (Vertex* v : vertices_)
+	//remove cell edges from the cells outside them
+	for (HalfEdge* h : loop) T->unlink(h->twin);
+	
+	//reconnect incident edges so that they meet at r_0, each vertex has one edge left that is not an edge of this cell
+	for (HalfEdge* h : loop)
 	{
-		Edge* e = *(v->edgeContacts().begin());				//only element left in the vertex edge_contacts (incident edge)
-		e->swapVertex(v, v_new);							//reconnect incident edges so that they meet at r_0, this deletes the old vertex and tells cells it no longer has this vertex
+		for (Edge* e : h->v->edgeContacts())
+		{
+			if (e != h->e && e != h->prev->e)
+			{
+				for (Cell* c : e->cellJunctions()) v_new->addCellContact(c);
+				e->swapVertex(h->v, v_new);
+				break;
+			}
+		}
 	}
-	for (Cell* c : v_new->cellContacts()) while (!(c->valid())) c->rotateVertices();
-	
 	
 	std::vector<Cell*> neighbours_copy = neighbours_;
-	vertices_ = {}; edges_ = {};
-	T->destroyCell(this);
+	T->destroyCell(this); 										//edges of the cell have no cells left so they and the old vertices are destroyed
 	v_new->orderCellContacts();
 	for (Cell* c : neighbours_copy) c->findNeighbours();
 	
-	std::cout << "cell extruded\n";
+	return true;
 }
 
-void Cell::divide()
+const bool Cell::divide()
 {
-	if (vertices_.size() <= 3 || onBoundary()) { return; }
-	
-	int i_va = longestEdge_i();
-	Edge* e_a = edges_[i_va];
-	int i_vb = (i_va+edges_.size()/2)%edges_.size();
-	Edge* e_b = edges_[i_vb]; //edge opposite longest edge
-	
-	//midpoints of above edges
-	Point a = CGAL::midpoint(e_a->v1()->r(), e_a->v2()->r());
-	Point b = CGAL::midpoint(e_b->v1()->r(), e_b->v2()->r());
-	Vertex* v_a = T->createVertex(a); Vertex* v_b = T->createVertex(b); 
+	int n = size();
+	if (n <= 3 || onBoundary()) { return false; }
 	
-	//add newly created vertices to relevent cells at correct index
-	Cell* c_a = nullptr; Cell* c_b = nullptr; 
-	int i_ea; int i_eb;
-	auto addNewVertices = [this, c_a, c_b](Cell*& c_x, Edge* e_x, Vertex* v_x, int& i_ex)
-	{
-		if (e_x->cellJunctions().size() == 2)
-		{
-			auto it = e_x->cellJunctions().begin();
-			c_x = (*it == this) ? *std::next(it) : *it;
-			
-			//place vertex between e_xv1 and e_xv2
-			const std::vector<Vertex*>& c_x_vertices = c_x->vertices();			
-			std::vector<Vertex*>::const_iterator it1 = std::find(c_x_vertices.begin(), c_x_vertices.end(), e_x->v1());
-			std::vector<Vertex*>::const_iterator it2 = std::find(c_x_vertices.begin(), c_x_vertices.end(), e_x->v2());
-			if (it1 == c_x_vertices.begin() && it2 != (it1+1)) i_ex = 0;
-			else if (it2 == c_x_vertices.begin() && it1 != (it2+1)) i_ex = 0;
-			else i_ex = (it1 < it2) ? std::distance(c_x_vertices.begin(), it2) : std::distance(c_x_vertices.begin(), it1);
-			T->cellNewVertex(c_x, v_x, i_ex);
-		}
-	};
-	addNewVertices(c_a, e_a, v_a, i_ea); addNewVertices(c_b, e_b, v_b, i_eb);
-
-	Edge* e_new = T->createEdge(v_a, v_b); //edge dividng cell
-	Edge* e_a1 = nullptr; 
-	Edge* e_a2 = nullptr;
-	Edge* e_b1 = nullptr;
-	Edge* e_b2 = nullptr;
-	
-	//create edges so that e_x1 is always before e_x2 in vertex/edge ordering	
-	auto updateAB = [this](Cell* const c_x, Edge* const e_x, Vertex* const v_x, Edge*& e_x1, Edge*& e_x2)
-	{
-		const std::vector<Vertex*>& c_x_vertices = c_x->vertices();
-		std::vector<Vertex*>::const_iterator it_v1 = std::find(c_x_vertices.begin(), c_x_vertices.end(), e_x->v1());
-		std::vector<Vertex*>::const_iterator it_v2 = std::find(c_x_vertices.begin(), c_x_vertices.end(), e_x->v2());
-		
-		int i_vx1 = std::distance(c_x_vertices.begin(), it_v1); int i_vx2 = std::distance(c_x_vertices.begin(), it_v2);
-		if (((i_vx2+2) % c_x_vertices.size()) == i_vx1) { std::swap(it_v1, it_v2); std::swap(i_vx1, i_vx2); }
-
-		e_x1 = T->createEdge(*it_v1, v_x);
-		e_x2 = T->createEdge(*it_v2, v_x);
-		if (c_x != nullptr)
-		{
-			const std::vector<Edge*>& c_x_edges = c_x->edges();
-			int i = T->cellRemoveEdge(c_x, e_x);
-			if (i_vx2 != 1)
-			{
-				T->cellNewEdge(c_x, e_x2, i);
-				T->cellNewEdge(c_x, e_x1, i);
-			}
-			else
-			{
-				T->cellNewEdge(c_x, e_x2, 0);
-				T->cellNewEdge(c_x, e_x1, i+1);
-			}
-		}
-	};
-	updateAB(c_a, e_a, v_a, e_a1, e_a2); updateAB(c_b, e_b, v_b, e_b1, e_b2);
-	
-	
-	auto isEdge = [this](Edge* e, Vertex* v_1, Vertex* v_2) { return ( (v_1 == e->v1() && v_2 == e->v2()) || (v_1 == e->v2() && v_2 == e->v1()) ); };	
-	//find vertices of the two new cells in rotaional order
-	std::vector<Vertex*> c_p_vertices, c_q_vertices;
-	std::vector<Edge*> c_p_edges, c_q_edges;
-	bool f_q = !(i_va < i_vb); size_t n = vertices_.size();
-	for (int i = 0; i < n; i++) //neeed to fix
-	{
-		if (!f_q)
-		{ 
-			c_p_vertices.push_back(vertices_[i]);
-			if (isEdge(e_a, vertices_[i], vertices_[(i+1)%n]))
-			{
-				c_p_vertices.push_back(v_a);
-				c_p_vertices.push_back(v_b);
-				f_q = true;
-			}
-		}	
-		else
-		{
-			c_q_vertices.push_back(vertices_[i]);
-			if (isEdge(e_b, vertices_[i], vertices_[(i+1)%n]))
-			{
-				c_q_vertices.push_back(v_b);
-				c_q_vertices.push_back(v_a);		
-				f_q = false;
-			}
-		}
-	}
+	HalfEdge* h_a = longestEdge();
+	HalfEdge* h_b = h_a; 
+	for (int i = 0; i < n/2; i++) h_b = h_b->next; 			//edge opposite longest edge
 	
-	//update edges of two new cells in rotational order
-	size_t np = c_p_vertices.size();
-	for (int i = 0; i < np; i++)
-	{
-		if (isEdge(e_a2, c_p_vertices[i], c_p_vertices[(i+1)%np])) c_p_edges.push_back(e_a2);
-		else if (isEdge(e_b1, c_p_vertices[i], c_p_vertices[(i+1)%np])) c_p_edges.push_back(e_b1);
-		else if (isEdge(e_new, c_p_vertices[i], c_p_vertices[(i+1)%np])) c_p_edges.push_back(e_new);
-		else for (Edge* e : edges_) if (isEdge(e, c_p_vertices[i], c_p_vertices[(i+1)%np])) c_p_edges.push_back(e);
-	}
-	size_t nq = c_q_vertices.size();
-	for (int i = 0; i < nq; i++)
-	{
-		if (isEdge(e_b2, c_q_vertices[i], c_q_vertices[(i+1)%nq])) c_q_edges.push_back(e_b2);
-		else if (isEdge(e_a1, c_q_vertices[i], c_q_vertices[(i+1)%nq])) c_q_edges.push_back(e_a1);
-		else if (isEdge(e_new, c_q_vertices[i], c_q_vertices[(i+1)%nq])) c_q_edges.push_back(e_new);
-		else for (Edge* e : edges_) if (isEdge(e, c_q_vertices[i], c_q_vertices[(i+1)%nq])) c_q_edges.push_back(e);
-	}
+	//split both edges at their midpoints, the neighbouring cells gain the new vertices
+	Point a = midpoint(h_a->v->r(), h_a->twin->v->r());
+	Point b = midpoint(h_b->v->r(), h_b->twin->v->r());
+	Vertex* w_a = h_a->e->v2(); Vertex* w_b = h_b->e->v2(); 	//split edges keep v1, these ends meet new edges instead
+	Vertex* v_a = T->splitEdge(h_a->e, a); 
+	Vertex* v_b = T->splitEdge(h_b->e, b); 
 	
-	Cell* c_p = T->createCell(c_p_vertices, c_p_edges);
-	Cell* c_q = T->createCell(c_q_vertices, c_q_edges);
+	//half-edges of this cell leaving the new vertices
+	HalfEdge* h_va = (h_a->v == v_a) ? h_a : h_a->next;
+	HalfEdge* h_vb = (h_b->v == v_b) ? h_b : h_b->next;
 	
-	std::vector<Cell*> neighbour_copy = neighbours_;
-	T->destroyCell(this);
-	c_p->findNeighbours(); c_q->findNeighbours();
-	for (Cell* c : neighbour_copy) c->findNeighbours();
+	//edge dividing cell, this cell keeps the side starting at v_a
+	Cell* c_q = T->splitCell(this, h_va, h_vb);
 	
-	for (Vertex* v : c_p_vertices) v->orderCellContacts();
-	for (Vertex* v : c_q_vertices) v->orderCellContacts();
-	std::cout << "cell divided\n";
+	//only the vertices of c_q changed contacts, and only cells touching c_q have different neighbours
+	for (HalfEdge* h : c_q->halfEdges()) h->v->orderCellContacts();
+	w_a->orderCellContacts(); w_b->orderCellContacts();
+	findNeighbours(); c_q->findNeighbours();
+	for (Cell* c : c_q->neighbours()) if (c != this) c->findNeighbours();
+	for (Cell* c : w_a->cellContacts()) c->findNeighbours();
+	for (Cell* c : w_b->cellContacts()) c->findNeighbours();
+	return true;
 }
 
 
@@ -311,22 +183,23 @@ void Cell::calcR_0()
 {
     double x_sum = 0;
     double y_sum = 0;
-    for (Vertex* v : vertices_) 
+    int n = 0;
+    for (HalfEdge* h : halfEdges()) 
     {
-        x_sum += v->r().x();
-        y_sum += v->r().y();
+        x_sum += h->v->r().x();
+        y_sum += h->v->r().y();
+        n++;
     }
-    r_0_ = Point(x_sum/vertices_.size(), y_sum/vertices_.size());
+    r_0_ = Point(x_sum/n, y_sum/n);
 }
 
 void Cell::calcA()
 {
 	A_ = 0;
-	size_t n = vertices_.size();
-	for (int i = 0; i < n; i++)
+	for (HalfEdge* h : halfEdges())
 	{
-		Point r_i = vertices_[i]->r();
-		Point r_j = vertices_[(i+1)%n]->r();
+		const Point& r_i = h->v->r();
+		const Point& r_j = h->next->v->r();
 		A_ += r_i.x()*r_j.y() - r_j.x()*r_i.y();
 	} A_*= 0.5;
 }
@@ -334,50 +207,56 @@ void Cell::calcA()
 void Cell::calcL()
 {
 	L_ = 0; 
-	for (Edge* e : edges_) L_ += e->l(); //edge lengths must already be calculated
+	for (HalfEdge* h : halfEdges()) L_ += h->e->l(); //edge lengths must already be calculated
 }
 
-void Cell::calcT_A() { T_A_ = param::K_a*(A_-param::A_0); }
 
 void Cell::calcG()
 {
 	G[0]=0;	G[1]=0; G[2]=0;
 	calcR_0();
 	double x_0 = r_0_.x(); double y_0 = r_0_.y();
-	for (Vertex* v : vertices_)
+	int n = 0;
+	for (HalfEdge* h : halfEdges())
 	{
-		double x_v = v->r().x();
-		double y_v = v->r().y();
+		double x_v = h->v->r().x();
+		double y_v = h->v->r().y();
 		G[0]+=(x_v-x_0)*(x_v-x_0);	
 		G[1]+=(x_v-x_0)*(y_v-y_0);
 		G[2]+=(y_v-y_0)*(y_v-y_0);
+		n++;
 	}
 	
-	double f = 1.0/vertices_.size();
+	double f = 1.0/n;
 	G[0]*=f; G[1]*=f; G[2]*=f;
-	
+	shape();
+}
+
+void Cell::shape()
+{
 	lambda = 0.5*( G[0]+G[2] + std::sqrt( (G[0]+G[2])*(G[0]+G[2]) - 4*(G[0]*G[2]-G[1]*G[1]) ) );
 	n_ = Vec(1, (lambda-G[0])/G[1]) / std::sqrt( 1 + ((lambda-G[0])/G[1])*((lambda-G[0])/G[1]) );
 	
 	Z_ = 0.5*(G[0]-G[2]);
 	X_ = G[1];
+	double S = std::sqrt(Z_*Z_+X_*X_);
+	Zn_ = Z_/S; Xn_ = X_/S;
 }
 
 void Cell::calcm()
 {
-	size_t n = neighbours_.size();
-	double w = 0;
-	for (int i = 0; i < n; i++) w += T->D_angle(neighbours_[i], neighbours_[(i+1)%n]);
-	m_ = w*boost::math::constants::one_div_two_pi <double>();
+	m_ = T->winding(neighbours_, neighbour_edges_);
 }
 
 
 
 bool Cell::valid()
 {
-	if (vertices_.size() != edges_.size()) return false;
-	size_t n = vertices_.size();
-	for (int i = 0; i < n; i++) if ((edges_[i]->hasVertex(vertices_[i]) && edges_[i]->hasVertex(vertices_[(i+1)%n])) == false) return false;
+	for (HalfEdge* h : halfEdges()) 
+	{
+		if (h->c != this || h->next->prev != h || h->twin->twin != h) return false;
+		if (h->e->from(h->v) != h || h->next->v != h->twin->v) return false;
+	}
 	return true;
 }
 
@@ -400,3 +279,16 @@ void Cell::outputEdgeVertices() const
 	for (int e : edges) std::cout << T->edge(e).v1() << ' ' << T->edge(e).v2() << "   "; 
 	std::cout << '\n';
 }*/
+
+void Cell::save(CheckpointOut& out) const
+{
+	out.put(T->h_id(h_));
+	out.put(S_); 		//orientation is fixed when the cell is created
+}
+
+void Cell::load(CheckpointIn& in, Tissue* tissue, int id)
+{
+	T = tissue; id_ = id;
+	h_ = T->h_at(in.get<int>());
+	S_ = in.get<double>();
+}
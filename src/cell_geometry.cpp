@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <cmath>
+
+#include "cell_geometry.h"
+#include "vertex.h"
+#include "edge.h"
+#include "cell.h"
+#include "model.h"
+
+
+CellGeometry::CellGeometry() : width_(4), relayout_(true) {}
+
+void CellGeometry::touch(int id)
+{
+	if (id >= static_cast<int>(is_dirty_.size())) is_dirty_.resize(id + 1, false);
+	if (is_dirty_[id]) return;
+	is_dirty_[id] = true;
+	dirty_.push_back(id);
+}
+void CellGeometry::touchAll() { relayout_ = true; }
+
+void CellGeometry::buildRow(const Slab<Cell>& c_arr, int id)
+{
+	int b = id / LANES; int j = id % LANES;
+	int n = 0;
+	if (c_arr.alive(id))
+	{
+		for (HalfEdge* h : c_arr[id].halfEdges())
+		{
+			int i = (b*width_ + n)*LANES + j;
+			v_id_[i] = h->v->id(); e_id_[i] = h->e->id();
+			n++;
+		}
+	}
+	n_[id] = n;
+	for (int k = n; k < width_; k++)
+	{
+		int i = (b*width_ + k)*LANES + j;
+		v_id_[i] = n > 0 ? v_id_[(b*width_)*LANES + j] : 0;
+		e_id_[i] = n > 0 ? e_id_[(b*width_)*LANES + j] : 0;
+	}
+}
+
+template <typename Model>
+void CellGeometry::update(Slab<Vertex>& v_arr, Slab<Edge>& e_arr, Slab<Cell>& c_arr, ThreadPool& pool, const Parameters& p)
+{
+	//positions and lengths into flat arrays the kernel can gather from
+	x_.resize(std::max(v_arr.size(), 1)); y_.resize(x_.size()); l_.resize(std::max(e_arr.size(), 1));
+	pool.forEach(v_arr.live(), [this](Vertex* v) { x_[v->id()] = v->r().x(); y_[v->id()] = v->r().y(); });
+	pool.forEach(e_arr.live(), [this](Edge* e) { e->calcLength(); l_[e->id()] = e->l(); });
+	
+	//rows of changed cells, all rows when there are new blocks or a loop no longer fits
+	int blocks = (c_arr.size() + LANES - 1)/LANES;
+	for (int id : dirty_) if (id < c_arr.size() && c_arr.alive(id) && c_arr[id].size() > width_) { width_ = (c_arr[id].size() + 3)/4*4; relayout_ = true; }
+	if (relayout_ || static_cast<int>(n_.size()) < blocks*LANES)
+	{
+		if (relayout_) { for (Cell* c : c_arr.live()) width_ = std::max(width_, (c->size() + 3)/4*4); }
+		int old = relayout_ ? 0 : n_.size();
+		n_.resize(blocks*LANES, 0);
+		v_id_.resize(blocks*width_*LANES, 0); e_id_.resize(v_id_.size(), 0);
+		for (int id = old; id < c_arr.size(); id++) buildRow(c_arr, id);
+		relayout_ = false;
+	}
+	for (int id : dirty_) { if (id < c_arr.size()) buildRow(c_arr, id); is_dirty_[id] = false; }
+	dirty_.clear();
+	
+	pool.forEachIndex(blocks, [this, &c_arr, &p](long b) { block<Model>(c_arr, p, b); });
+}
+
+template <typename Model>
+void CellGeometry::block(Slab<Cell>& c_arr, const Parameters& p, int b)
+{
+	const int* n = &n_[b*LANES];
+	int k_max = *std::max_element(n, n + LANES);
+	if (k_max == 0) return;
+	
+	double L[LANES] = {}, x_sum[LANES] = {}, y_sum[LANES] = {};
+	thread_local std::vector<double> px, py; 		//gathered corners, [k*LANES + lane]
+	px.resize(k_max*LANES); py.resize(k_max*LANES);
+	
+	//one gather over the corners, perimeter and centroid sums in loop order for every lane
+	for (int k = 0; k < k_max; k++)
+	{
+		const int* v = &v_id_[(b*width_ + k)*LANES];
+		const int* e = &e_id_[(b*width_ + k)*LANES];
+		for (int j = 0; j < LANES; j++)
+		{
+			bool in = k < n[j];
+			double x_k = x_[v[j]]; double y_k = y_[v[j]];
+			px[k*LANES + j] = x_k; py[k*LANES + j] = y_k;
+			L[j] += in ? l_[e[j]] : 0.0;
+			x_sum[j] += in ? x_k : 0.0;
+			y_sum[j] += in ? y_k : 0.0;
+		}
+	}
+	double x_0[LANES], y_0[LANES];
+	for (int j = 0; j < LANES; j++) { x_0[j] = x_sum[j]/std::max(n[j], 1); y_0[j] = y_sum[j]/std::max(n[j], 1); }
+	
+	//gyration tensor about the centroid from the gathered corners
+	double G_0[LANES] = {}, G_1[LANES] = {}, G_2[LANES] = {};
+	for (int k = 0; k < k_max; k++)
+	{
+		for (int j = 0; j < LANES; j++)
+		{
+			bool in = k < n[j];
+			double dx = px[k*LANES + j] - x_0[j]; double dy = py[k*LANES + j] - y_0[j];
+			G_0[j] += in ? dx*dx : 0.0;
+			G_1[j] += in ? dx*dy : 0.0;
+			G_2[j] += in ? dy*dy : 0.0;
+		}
+	}
+	
+	for (int j = 0; j < LANES; j++)
+	{
+		if (n[j] == 0) continue;
+		Cell& c = c_arr[b*LANES + j];
+		double f = 1.0/n[j];
+		c.L_ = L[j];
+		c.r_0_ = Point(x_0[j], y_0[j]);
+		c.G[0] = G_0[j]*f; c.G[1] = G_1[j]*f; c.G[2] = G_2[j]*f;
+		c.shape();
+		c.calcT_A<Model>(p);
+	}
+}
+
+#define INSTANTIATE(Model) template void CellGeometry::update<Model>(Slab<Vertex>&, Slab<Edge>&, Slab<Cell>&, ThreadPool&, const Parameters&);
+FOR_EACH_MODEL(INSTANTIATE)
+#undef INSTANTIATE
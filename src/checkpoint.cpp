@@ -0,0 +1,30 @@
+#include <fstream>
+#include <cstdio>
+#include <stdexcept>
+
+#include "checkpoint.h"
+
+
+void CheckpointOut::write(const std::string& filename) const
+{
+	std::string tmp = filename + ".tmp";
+	std::ofstream file(tmp, std::ios::binary);
+	file.write(buf_.data(), buf_.size());
+	file.close();
+	if (!file) throw std::runtime_error("could not write checkpoint " + tmp);
+	if (std::rename(tmp.c_str(), filename.c_str()) != 0) throw std::runtime_error("could not replace checkpoint " + filename + " with " + tmp);
+}
+
+CheckpointIn::CheckpointIn(const std::string& filename) : pos_(0)
+{
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+	if (!file) throw std::runtime_error("could not open checkpoint " + filename);
+	buf_.resize(file.tellg());
+	file.seekg(0);
+	file.read(buf_.data(), buf_.size());
+}
+
+void CheckpointIn::need(size_t bytes) const
+{
+	if (pos_ + bytes > buf_.size()) throw std::runtime_error("checkpoint is truncated");
+}
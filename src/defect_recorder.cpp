@@ -0,0 +1,77 @@
+#include <filesystem>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "defect_recorder.h"
+
+static const char DEFECT_MAGIC[8] = { 'D', 'E', 'F', 'E', 'C', 'T', 'S', '1' };
+static const char DEFECT_HEADER[] = "timestep PLUSHALF PLUSONE MINUSHALF MINUSONE\n";
+
+
+DefectRecorder::DefectRecorder(const std::string& filename, int interval, int decimation, bool binary, const State* resume) : 
+	filename_(filename), interval_(std::max(interval, 1)), decimation_(std::max(decimation, 1)), binary_(binary), rows_(0), bytes_(0), samples_(0), first_(0)
+{
+	sum_ = {0, 0, 0, 0};
+	if (resume != nullptr && resume->bytes > 0 && std::filesystem::exists(filename))
+	{
+		std::filesystem::resize_file(filename, resume->bytes); 		//rows written after the checkpoint are dropped
+		file_.open(filename, std::ios::binary | std::ios::app);
+		bytes_ = resume->bytes;
+		sum_ = resume->sum; samples_ = resume->samples; first_ = resume->first;
+	}
+	else
+	{
+		file_.open(filename, std::ios::binary | std::ios::trunc);
+		if (binary_) buf_.insert(buf_.end(), DEFECT_MAGIC, DEFECT_MAGIC + 8);
+		else buf_.insert(buf_.end(), DEFECT_HEADER, DEFECT_HEADER + sizeof(DEFECT_HEADER) - 1);
+	}
+	if (!file_) throw std::runtime_error("could not open defect file " + filename);
+	buf_.reserve(64*DEFECT_FLUSH_ROWS);
+}
+DefectRecorder::~DefectRecorder() { file_.write(buf_.data(), buf_.size()); }
+
+void DefectRecorder::record(int timestep, const std::array<int, 4>& counts)
+{
+	if (samples_ == 0) first_ = timestep;
+	for (int i = 0; i < 4; i++) sum_[i] += counts[i];
+	if (++samples_ < decimation_) return;
+	addRow();
+	sum_ = {0, 0, 0, 0}; samples_ = 0;
+	if (++rows_ >= DEFECT_FLUSH_ROWS) flush();
+}
+
+void DefectRecorder::addRow()
+{
+	if (binary_)
+	{
+		char row[20];
+		int32_t t = first_;
+		std::memcpy(row, &t, 4);
+		for (int i = 0; i < 4; i++) { float x = sum_[i]/samples_; std::memcpy(row + 4 + 4*i, &x, 4); }
+		buf_.insert(buf_.end(), row, row + 20);
+	}
+	else
+	{
+		char row[128];
+		int n = std::snprintf(row, sizeof(row), "%d %g %g %g %g\n", first_, sum_[0]/samples_, sum_[1]/samples_, sum_[2]/samples_, sum_[3]/samples_);
+		buf_.insert(buf_.end(), row, row + n);
+	}
+}
+
+void DefectRecorder::flush()
+{
+	if (buf_.empty()) return;
+	file_.write(buf_.data(), buf_.size());
+	file_.flush();
+	if (!file_) throw std::runtime_error("could not write defect file " + filename_);
+	bytes_ += buf_.size();
+	buf_.clear(); rows_ = 0;
+}
+
+DefectRecorder::State DefectRecorder::state()
+{
+	flush();
+	return State{bytes_, sum_, samples_, first_};
+}
@@ -2,161 +2,152 @@
 #include "tissue.h"
 
 
-Edge::Edge(Tissue* T, Vertex* v_1, Vertex* v_2) : 
-	T(T)
+Edge::Edge(Tissue* T, int id, Vertex* v_1, Vertex* v_2) : 
+	T(T), id_(id)
 {
-	this->v_1 = v_1;
-	this->v_2 = v_2;
+	h_[0] = {v_1, this, nullptr, &h_[1], nullptr, nullptr};
+	h_[1] = {v_2, this, nullptr, &h_[0], nullptr, nullptr};
+	calcLength(); 		//division reads lengths of edges made earlier in the same step, before geometry is updated
 }
 Edge::Edge() = default;
 
-bool Edge::operator==(const Edge& other) const { return ((v_1 == other.v_1) && (v_2 == other.v_2)) || ((v_1== other.v_2) && (v_2 == other.v_1)); }
+bool Edge::operator==(const Edge& other) const { return ((v1() == other.v1()) && (v2() == other.v2())) || ((v1() == other.v2()) && (v2() == other.v1())); }
 
-Vertex* const Edge::v1()		const { return v_1; }
-Vertex* const Edge::v2() 		const { return v_2; }
+const int Edge::id()		const { return id_; }
+Vertex* const Edge::v1()		const { return h_[0].v; }
+Vertex* const Edge::v2() 		const { return h_[1].v; }
 const double Edge::l() 		const { return l_; }
 const double Edge::T_l()	const { return T_l_; }
-const std::unordered_set<Cell*>& Edge::cellJunctions()	const { return cell_junctions_; }
+const SmallSet<Cell*, 2> Edge::cellJunctions()	const 
+{ 
+	SmallSet<Cell*, 2> cells;
+	for (const HalfEdge& h : h_) if (h.c != nullptr) cells.insert(h.c);
+	return cells;
+}
 
+const Vec& Edge::force(Vertex* v) const { return (v == h_[0].v) ? f_[0] : f_[1]; }
 
-void Edge::addCellJunction(Cell* c) { cell_junctions_.insert(c); }
-void Edge::removeCellJunction(Cell* c) 
-{
-    cell_junctions_.erase(c);
-    if (cell_junctions_.size() == 0) T->destroyEdge(this);
-}
+HalfEdge* const Edge::h(int i) { return &h_[i]; }
+HalfEdge* const Edge::from(Vertex* v) { return (h_[0].v == v) ? &h_[0] : &h_[1]; }
 
-const bool Edge::hasVertex(Vertex* v) const { return (v == v_1 || v == v_2); }
+
+const bool Edge::hasVertex(Vertex* v) const { return (v == h_[0].v || v == h_[1].v); }
 
 bool Edge::swapVertex(Vertex* v_old, Vertex* v_new)
 {
-	if (v_old == v_1) 
+	for (HalfEdge& h : h_)
 	{
-		v_1 = v_new;
-		for (Cell* c : cell_junctions_) T->cellExchangeVertex(c, v_old, v_new);
-		v_new->addEdgeContact(this);
-		v_old->removeEdgeContact(this);
-		return true;
-	}
-	else if (v_old == v_2) 
-	{
-		v_2 = v_new;
-		for (Cell* c : cell_junctions_) T->cellExchangeVertex(c, v_old, v_new);
-		v_new->addEdgeContact(this);
-		v_old->removeEdgeContact(this);
-		return true;
+		if (h.v == v_old)
+		{
+			h.v = v_new;
+			v_new->addEdgeContact(this);
+			v_old->removeEdgeContact(this);
+			T->watchEdge(this);
+			for (const HalfEdge& g : h_) if (g.c != nullptr) T->watchLoop(g.c); 	//both cells have a new corner
+			return true;
+		}
 	}
-	else { return false;}
+	return false;
 }
 
-bool Edge ::swapVertex_noedit(Vertex* v_old, Vertex* v_new)
+
+void Edge::calcLength() { l_ = std::sqrt((v1()->r()-v2()->r()).squared_length()); }
+
+void Edge::calcTurn()
 {
-	if (v_old == v_1) 
-	{
-		v_1 = v_new;
-		v_new->addEdgeContact(this);
-		v_old->removeEdgeContact(this);
-		return true;
-	}
-	else if (v_old == v_2) 
-	{
-		v_2 = v_new;
-		v_new->addEdgeContact(this);
-		v_old->removeEdgeContact(this);
-		return true;
-	}
-	else { return false;}
+	Cell* c_0 = h_[0].c; Cell* c_1 = h_[1].c;
+	if (c_0 == nullptr || c_1 == nullptr) return;
+	turn_s_ = c_0->Zn()*c_1->Xn() - c_0->Xn()*c_1->Zn();
+	turn_c_ = c_0->Zn()*c_1->Zn() + c_0->Xn()*c_1->Xn();
 }
+const double Edge::turnS(Cell* from) const { return from == h_[0].c ? turn_s_ : -turn_s_; }
+const double Edge::turnC() const { return turn_c_; }
 
 
-void Edge::calcLength() { l_ = std::sqrt((v_1->r()-v_2->r()).squared_length()); }
 
-void Edge::calcT_l()
+void Edge::calcForce()
 {
-	T_l_ = param::LAMBDA;
-	for (const Cell* c: cell_junctions_) T_l_ += param::GAMMA*c->L();
+	//area gradient of a polygon splits into one term per side acting equally on both of its vertices,
+	//the cells either side traverse the edge in opposite directions so their terms combine
+	Vec d = v2()->r() - v1()->r();
+	double s = 0;
+	if (h_[0].c != nullptr) s += h_[0].c->S()*h_[0].c->T_A();
+	if (h_[1].c != nullptr) s -= h_[1].c->S()*h_[1].c->T_A();
+	Vec f_A = -0.5*s*Vec(d.y(), -d.x());
+	
+	Vec f_L = (T_l_/l_)*d; 		//line tension pulls the vertices together, edge length must already be calculated
+	f_[0] = f_A + f_L;
+	f_[1] = f_A - f_L;
 }
 
 
-void Edge::T1()
+const bool Edge::T1()
 {
-	if (cell_junctions_.size() != 2) return;
-	if (v_1->cellContacts().size() != 3 || v_2->cellContacts().size() != 3) return;
+	//cells either side of edge, c_a is traversed v_1 -> v_2
+	HalfEdge* const h_a = &h_[0]; HalfEdge* const h_b = &h_[1];
+	Cell* const c_a = h_a->c; Cell* const c_b = h_b->c;
+	if (c_a == nullptr || c_b == nullptr) return false;
+	Vertex* const v_1 = h_a->v; Vertex* const v_2 = h_b->v;
+	if (v_1->cellContacts().size() != 3 || v_2->cellContacts().size() != 3) return false;
 	
-	//cells either side of edge
-	Cell* const c_a = *(cell_junctions_.begin());
-	Cell* const c_b = *std::next(cell_junctions_.begin());
-	const std::unordered_set<Cell*> cellsAB = {c_a, c_b};
+	//neighbouring half-edges, a_in ends at v_1 and b_out starts at v_1, b_in ends at v_2 and a_out starts at v_2
+	HalfEdge* const a_in = h_a->prev; HalfEdge* const a_out = h_a->next;
+	HalfEdge* const b_in = h_b->prev; HalfEdge* const b_out = h_b->next;
 	
-	//copy of edge contacts
-	const std::unordered_set<Edge*> v_1_edges = v_1->edgeContacts();
-	const std::unordered_set<Edge*> v_2_edges = v_2->edgeContacts();
+	//cells at the ends of the edge, the half-edges entering v_1 in c_p and v_2 in c_q
+	HalfEdge* const p_in = b_out->twin; HalfEdge* const q_in = a_out->twin;
+	Cell* const c_p = p_in->c; Cell* const c_q = q_in->c;
+	if (c_p == nullptr || c_q == nullptr || c_p == c_q) return false;
+	if (a_in->twin != p_in->next || b_in->twin != q_in->next) return false; 	//both vertices must be threefold
 	
-	auto other_cell = [this, cellsAB](Vertex* const v) { for (Cell* c : v->cellContacts()) if (cellsAB.find(c) == cellsAB.end()) return c; };
-	Cell* const c_p = other_cell(v_1);
-	Cell* const c_q = other_cell(v_2);
-	
-	//create new vertices
-	Point cen = CGAL::midpoint(v_1->r(), v_2->r());
+	//new vertex positions, perpendicular to the edge, v_1 stays in c_a so it takes the point nearer c_a
+	Point cen = midpoint(v_1->r(), v_2->r());
 	Vec u = v_2->r() - v_1->r(); Vec s(-u.y(), u.x()); //s is u rotated 90 anticlockwise
-	s *= (param::l_new/s.squared_length());
-	Point a = cen + param::l_new*s; Point b = cen - param::l_new*s;
+	const double l_new = T->param().l_new;
+	s *= (l_new/s.squared_length());
+	Point a = cen + l_new*s; Point b = cen - l_new*s;
 	c_a->calcR_0(); Point r_0 = c_a->r_0();
-	if ( CGAL::squared_distance(a, r_0) > CGAL::squared_distance(b, r_0) ) std::swap(a,b);
-	Vertex* const v_a = T->createVertex(a); Vertex* const v_b = T->createVertex(b);
-	Edge* const e_new = T->createEdge(v_a, v_b);
+	if ( squared_distance(a, r_0) > squared_distance(b, r_0) ) std::swap(a,b);
 	
-	//replace edge in cells a and b with vertices a and b respectively
-	auto edgeToVertex = [this](Cell* const c_x, Vertex* const v_x)
-	{
-		const std::vector<Edge*>& edges = c_x->edges();
-		for (Edge* e : edges)
-		{
-			if (e != this) 
-			{
-				e->swapVertex(v_1, v_x);
-				e->swapVertex(v_2, v_x);
-			}
-		}
-		T->cellRemoveEdge(c_x, this);
-	};
-	edgeToVertex(c_a, v_a); edgeToVertex(c_b, v_b);
+	//remove edge from cells a and b, exchange the outer edges between the vertices and insert edge in cells p and q
+	T->unlink(h_a); T->unlink(h_b);
+	a_out->e->swapVertex(v_2, v_1);
+	b_out->e->swapVertex(v_1, v_2);
+	T->insertAfter(p_in, h_b);
+	T->insertAfter(q_in, h_a);
 	
-	auto VertexToEdge = [this, c_a, c_b, v_a, v_b, e_new](Cell* const c_x, const std::unordered_set<Edge*>& v_edges)
-	{
-		const std::vector<Vertex*>& c_x_vertices = c_x->vertices();
-		std::vector<Vertex*>::const_iterator it_v_a = std::find(c_x_vertices.begin(), c_x_vertices.end(), v_a);
-		int i_v_a = std::distance(c_x_vertices.begin(), it_v_a);
-		
-		Edge* e_a = nullptr; Edge* e_b = nullptr;
-		for (Edge* e : v_edges)
-		{
-			if (c_a->hasEdge(e)) e_a = e;
-			else if (c_b->hasEdge(e)) e_b = e;
-		}
-		
-		const std::vector<Edge*>& c_x_edges = c_x->edges(); int n = c_x_edges.size();
-		for (int i = 0; i < n; i++)
-		{
-			if (c_x_edges[i] == e_a && c_x_edges[(i+1)%n] == e_b)
-			{
-				T->cellNewEdge(c_x, e_new, (i+1)%n);
-				T->cellNewVertex(c_x, v_b, (i+2)%n);
-				break;
-			}
-			else if (c_x_edges[i] == e_b && c_x_edges[(i+1)%n] == e_a)
-			{
-				T->cellNewEdge(c_x, e_new, (i+1)%n);
-				T->cellNewVertex(c_x, v_b, (i+1)%n);
-				break;
-			}
-		}
-	};
-	VertexToEdge(c_p, v_1_edges); VertexToEdge(c_q, v_2_edges);
+	v_1->removeCellContact(c_b); v_1->addCellContact(c_q);
+	v_2->removeCellContact(c_a); v_2->addCellContact(c_p);
+	v_1->setR(a); v_2->setR(b);
 	
-	while (!(c_p->valid())) { c_p->rotateVertices(); }
-	while (!(c_q->valid())) { c_q->rotateVertices(); }
-	v_a->orderCellContacts(); v_b->orderCellContacts();
-	std::cout << "T1\n";
+	v_1->orderCellContacts(); v_2->orderCellContacts();
+	c_a->findNeighbours(); c_b->findNeighbours(); c_p->findNeighbours(); c_q->findNeighbours();
+	return true;
+}
+
+void Edge::save(CheckpointOut& out) const
+{
+	for (const HalfEdge& h : h_)
+	{
+		out.put(h.v->id());
+		out.put(T->h_id(h.next));
+		out.put(T->h_id(h.prev));
+		out.put(h.c == nullptr ? -1 : h.c->id());
+	}
+	out.put(l_); 		//division picks the longest edge before lengths are recalculated
 }
 
+void Edge::load(CheckpointIn& in, Tissue* tissue, int id)
+{
+	T = tissue; id_ = id;
+	for (int i = 0; i < 2; i++)
+	{
+		HalfEdge& h = h_[i];
+		h.v = T->v_at(in.get<int>());
+		h.e = this; h.twin = &h_[1-i];
+		h.next = T->h_at(in.get<int>());
+		h.prev = T->h_at(in.get<int>());
+		h.c = T->c_at(in.get<int>());
+	}
+	l_ = in.get<double>();
+}
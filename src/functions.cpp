@@ -1,11 +1,67 @@
 #include "functions.h"
 
 
-double random(double min, double max, unsigned int seed)
+double random(double min, double max, unsigned int seed) { return min + (max-min)*Philox::uniform(seed, RNG_SEEDING, 0, 0); }
+
+std::vector<Point> randomPoints(unsigned int n, uint64_t seed) 
+{ 
+	std::vector<Point> points;
+	double w = std::sqrt(n);
+	for (int i = 0; i < n; i++)
+	{
+		Vec u = Philox::uniform2(seed, RNG_SEEDING, i, 0);
+		points.push_back(Point(w*(u.x()-0.5), w*(u.y()-0.5)));
+	}
+	return points;
+}
+std::vector<Point> hexagonalWithNoise(unsigned int n, double g, uint64_t seed)
+{
+	std::vector<Point> points;
+	double k = std::sqrt(n);
+	for (int i = -k/2; i < k/2; i++)
+	{
+		for (int j = -k/2; j < k/2; j++)
+		{
+			Vec u = Philox::uniform2(seed, RNG_SEEDING, points.size(), 0);
+			Point p(i+g*(u.x()-0.5), j+0.5*(i%2)+g*(u.y()-0.5));
+			points.push_back(p);
+		}
+	}
+	return points;
+}
+CellMesh hexagonalCells(unsigned int n)
 {
-    std::mt19937 generator(seed);
-    std::uniform_real_distribution<double> dist(min, max);
-    return dist(generator);
+	//corners lie on the lines between neighbouring columns at every half unit of height, so a corner is found from its gap
+	//and height without searching, it is 5/8 from the column with a point level with it and 3/8 from the other
+	CellMesh mesh;
+	double k = std::sqrt(n);
+	int i_0 = -k/2; 				//same points as hexagonalWithNoise, columns and rows both run from i_0 to below k/2
+	int m = 0;
+	while (i_0 + m < k/2) m++;
+	int h_0 = 2*i_0 - 2; 			//lowest corner, in half units
+	int H = 2*m + 3; 				//corner heights in each gap
+	
+	std::vector<int> index((m+1)*H, -1); 		//vertex of each corner, numbered as they are first used so none are left without a cell
+	mesh.vertices.reserve(2*m*m + 4*m);
+	auto corner = [&](int gap, int h, double x)
+	{
+		int& v = index[gap*H + h - h_0];
+		if (v < 0) { v = mesh.vertices.size(); mesh.vertices.push_back(Point(x, 0.5*h)); }
+		return v;
+	};
+	
+	mesh.faces.reserve(m*m);
+	for (int i = i_0; i < i_0 + m; i++)
+	{
+		int gap = i - i_0; 			//gap left of column i
+		for (int j = i_0; j < i_0 + m; j++)
+		{
+			int h = 2*j + i%2; 		//height of the point in half units
+			mesh.faces.push_back({ corner(gap+1, h, i+0.625), corner(gap+1, h+1, i+0.375), corner(gap, h+1, i-0.375), 
+								   corner(gap, h, i-0.625), corner(gap, h-1, i-0.375), corner(gap+1, h-1, i+0.375) }); 	//anticlockwise
+		}
+	}
+	return mesh;
 }
 
 
@@ -21,96 +77,279 @@ double random(double min, double max, unsigned int seed)
     }
 }*/
 
-void writeCellsFile(Tissue* T, const std::string& filename_cells)
+static void addPoint(std::vector<float>& points, const Point& r)
 {
-	std::vector<Vertex*> vertices = T->vertices();
-	Vertex* v_0 = T->v_0();
-	std::unordered_map<int, int> index_map;
-    int index = 0;
-    for (Vertex* v : vertices) { index_map[v-v_0] = index++; }
-
-    std::ofstream graphFile(filename_cells);
-    graphFile << "# vtk DataFile Version 2.0\nGraph\nASCII\nDATASET UNSTRUCTURED_GRID\nPOINTS " << vertices.size() << " float\n";
-    for (Vertex* v : vertices) { graphFile << v->r().x() << " " << v->r().y() << " 0\n"; }
-    
-    std::vector<Cell*> cells = T->cells();
-    Cell* c_0 = T->c_0();
-    int n = 0; for (Cell* c : cells) { n += c->vertices().size(); }
-    n += cells.size();
-    graphFile << "CELLS " << cells.size() << " " << n << '\n';
-    for (Cell* c : cells) 
-    {
-		graphFile << c->vertices().size() << " ";
-		for (Vertex* v : c->vertices()) { graphFile << index_map[v-v_0] << " "; }
-		graphFile << '\n';
-	}
-	
-	graphFile << "CELL_TYPES " << cells.size() << '\n';
-	for (int c = 0; c < cells.size(); c++) { graphFile << "7\n"; }
+	points.push_back(r.x());
+	points.push_back(r.y());
+	points.push_back(0);
+}
+
+void fillCells(Tissue* T, Polygons& cells)
+{
+	const std::vector<Vertex*>& vertices = T->vertices();
+	cells.clear();
+	cells.points.reserve(3*vertices.size());
+	for (Vertex* v : vertices) addPoint(cells.points, v->r());
 	
-    graphFile.close();
+	cells.connectivity.reserve(6*T->cells().size());
+	cells.offsets.reserve(T->cells().size());
+	for (Cell* c : T->cells())
+	{
+		for (HalfEdge* h : c->halfEdges()) cells.connectivity.push_back(T->v_index(h->v));
+		cells.offsets.push_back(cells.connectivity.size());
+	}
 }
 
-void writeDirectorsFile(Tissue* T, const std::string& filename_directors)
+void fillDirectors(Tissue* T, std::vector<float>& directors)
+{
+	directors.clear();
+	directors.reserve(6*T->cells().size());
+	for (Cell* c : T->cells())
+	{
+		addPoint(directors, c->r_0()-0.5*c->n());
+		addPoint(directors, c->r_0()+0.5*c->n());
+	}
+}
+
+void fillCellDefects(const std::vector<Cell*>& c_def, Polygons& defects)
+{
+	//corners are written once per defect cell so connectivity is just their running index
+	defects.clear();
+	for (Cell* c : c_def)
+	{
+		for (HalfEdge* h : c->halfEdges())
+		{
+			defects.connectivity.push_back(defects.connectivity.size());
+			addPoint(defects.points, h->v->r());
+		}
+		defects.offsets.push_back(defects.connectivity.size());
+	}
+}
+
+void fillVertexDefects(const std::vector<Vertex*>& v_def, std::vector<float>& defects)
+{
+	defects.clear();
+	defects.reserve(3*v_def.size());
+	for (Vertex* v : v_def) addPoint(defects, v->r());
+}
+
+
+void writePolygonsVTK(const Polygons& p, const std::string& filename, const std::string& name)
 {
-	std::vector<Cell*> cells = T->cells();
-	size_t n = cells.size();
+	int n_points = p.points.size()/3, n = p.offsets.size();
+	std::ofstream file(filename);
+	file << "# vtk DataFile Version 2.0\n" << name << "\nASCII\nDATASET UNSTRUCTURED_GRID\nPOINTS " << n_points << " float\n";
+	for (int i = 0; i < n_points; i++) file << p.points[3*i] << " " << p.points[3*i+1] << " 0\n";
 	
-	std::ofstream directorFile(filename_directors);
-    directorFile << "# vtk DataFile Version 2.0\nns\nASCII\nDATASET POLYDATA\nPOINTS " << 2*n << " float\n";
-    for (Cell* c : cells) 
-    { 
-		directorFile << (c->r_0()-0.5*c->n()).x() << " " << (c->r_0()-0.5*c->n()).y() << " 0\n";
-		directorFile << (c->r_0()+0.5*c->n()).x() << " " << (c->r_0()+0.5*c->n()).y() << " 0\n";
+	file << "CELLS " << n << " " << p.connectivity.size() + n << '\n';
+	int start = 0;
+	for (int end : p.offsets)
+	{
+		file << end - start << " ";
+		for (int i = start; i < end; i++) file << p.connectivity[i] << " ";
+		file << '\n';
+		start = end;
 	}
 	
-	directorFile << "LINES " << n << " " << 3*n << "\n";
-	for (int i = 0; i < n; i++) { directorFile << "2 " << 2*i << " " << 2*i+1 << "\n"; }
+	file << "CELL_TYPES " << n << '\n';
+	for (int i = 0; i < n; i++) file << "7\n";
+	file.close();
+}
+
+void writeLinesVTK(const std::vector<float>& points, const std::string& filename)
+{
+	int n = points.size()/6;
+	std::ofstream file(filename);
+	file << "# vtk DataFile Version 2.0\nns\nASCII\nDATASET POLYDATA\nPOINTS " << 2*n << " float\n";
+	for (int i = 0; i < 2*n; i++) file << points[3*i] << " " << points[3*i+1] << " 0\n";
+	
+	file << "LINES " << n << " " << 3*n << "\n";
+	for (int i = 0; i < n; i++) file << "2 " << 2*i << " " << 2*i+1 << "\n";
+	file.close();
+}
+
+void writePointsVTK(const std::vector<float>& points, const std::string& filename)
+{
+	int n = points.size()/3;
+	std::ofstream file(filename);
+	file << "# vtk DataFile Version 2.0\nPoint data\nASCII\nDATASET POLYDATA\n";
+	file << "POINTS " << n << " float\n";
+	for (int i = 0; i < n; i++) file << points[3*i] << " " << points[3*i+1] << " 0\n";
 	
-	directorFile.close();
+	file << "VERTICES " << n << " " << 2*n << "\n";
+	for (int i = 0; i < n; i++) file << "1 " << i << "\n";
+	file.close();
 }
 
-void writeCellDefectsFile(Tissue* T, const std::vector<Cell*>& c_def, const std::string& filename_c_def)
+
+namespace
 {
-	std::unordered_set<Vertex*> def_vertices;
-	for (Cell* c : c_def) { def_vertices.insert(c->vertices().begin(), c->vertices().end()); }
-			
-	std::unordered_map<int, int> index_map;
-	int index = 0; Vertex* v_0 = T->v_0();
-	for (Vertex* v : def_vertices) { index_map[v-v_0] = index++; }
+	//VTK XML file with every data array stored as raw bytes in a single appended block
+	class VtkAppended
+	{
+	private:
+	
+		std::ostringstream xml_;
+		std::vector<char> data_;
 		
-	std::ofstream defectFile(filename_c_def);
-	defectFile << "# vtk DataFile Version 2.0\nDefect\nASCII\nDATASET UNSTRUCTURED_GRID\nPOINTS " << def_vertices.size() << " float\n";
-	for (Vertex* v : def_vertices) { defectFile << v->r().x() << " " << v->r().y() << " 0\n"; }
+	public:
+	
+		VtkAppended(const char* type)
+		{
+			const uint16_t one = 1;
+			const char* byte_order = (*reinterpret_cast<const char*>(&one) == 1) ? "LittleEndian" : "BigEndian";
+			xml_ << "<?xml version=\"1.0\"?>\n<VTKFile type=\"" << type << "\" version=\"1.0\" byte_order=\"" << byte_order << "\" header_type=\"UInt64\">\n<" << type << ">\n";
+		}
+		
+		std::ostringstream& xml() { return xml_; }
+		
+		template <typename V>
+		void array(const char* type, const char* name, int components, const std::vector<V>& a)
+		{
+			xml_ << "<DataArray type=\"" << type << "\" Name=\"" << name << "\" NumberOfComponents=\"" << components << "\" format=\"appended\" offset=\"" << data_.size() << "\"/>\n";
+			uint64_t bytes = a.size()*sizeof(V);
+			const char* p = reinterpret_cast<const char*>(&bytes);
+			data_.insert(data_.end(), p, p + sizeof(bytes));
+			p = reinterpret_cast<const char*>(a.data());
+			data_.insert(data_.end(), p, p + bytes);
+		}
+		
+		void write(const char* type, const std::string& filename)
+		{
+			std::ofstream file(filename, std::ios::binary);
+			xml_ << "</" << type << ">\n<AppendedData encoding=\"raw\">\n_";
+			file << xml_.str();
+			file.write(data_.data(), data_.size());
+			file << "\n</AppendedData>\n</VTKFile>\n";
+			file.close();
+		}
+	};
+	
+	//points with one cell of the given kind per group of per_cell points
+	void writePolyDataVTP(const std::vector<float>& points, int per_cell, const char* kind, const std::string& filename)
+	{
+		int n_points = points.size()/3, n = n_points/per_cell;
+		std::vector<int32_t> connectivity(n_points), offsets(n);
+		for (int i = 0; i < n_points; i++) connectivity[i] = i;
+		for (int i = 0; i < n; i++) offsets[i] = per_cell*(i+1);
+		
+		VtkAppended vtk("PolyData");
+		vtk.xml() << "<Piece NumberOfPoints=\"" << n_points << "\" NumberOfVerts=\"" << (per_cell == 1 ? n : 0) << "\" NumberOfLines=\"" << (per_cell == 2 ? n : 0) << "\" NumberOfStrips=\"0\" NumberOfPolys=\"0\">\n<Points>\n";
+		vtk.array("Float32", "Points", 3, points);
+		vtk.xml() << "</Points>\n<" << kind << ">\n";
+		vtk.array("Int32", "connectivity", 1, connectivity);
+		vtk.array("Int32", "offsets", 1, offsets);
+		vtk.xml() << "</" << kind << ">\n</Piece>\n";
+		vtk.write("PolyData", filename);
+	}
+}
+
+void writePolygonsVTU(const Polygons& p, const std::string& filename)
+{
+	VtkAppended vtk("UnstructuredGrid");
+	vtk.xml() << "<Piece NumberOfPoints=\"" << p.points.size()/3 << "\" NumberOfCells=\"" << p.offsets.size() << "\">\n<Points>\n";
+	vtk.array("Float32", "Points", 3, p.points);
+	vtk.xml() << "</Points>\n<Cells>\n";
+	vtk.array("Int32", "connectivity", 1, p.connectivity);
+	vtk.array("Int32", "offsets", 1, p.offsets);
+	vtk.array("UInt8", "types", 1, std::vector<uint8_t>(p.offsets.size(), 7));
+	vtk.xml() << "</Cells>\n</Piece>\n";
+	vtk.write("UnstructuredGrid", filename);
+}
 
-	int n = 0; 
-	for (Cell* c : c_def) { n += c->vertices().size(); }
-	n += c_def.size();
+void writeLinesVTP(const std::vector<float>& points, const std::string& filename) { writePolyDataVTP(points, 2, "Lines", filename); }
+void writePointsVTP(const std::vector<float>& points, const std::string& filename) { writePolyDataVTP(points, 1, "Verts", filename); }
+
+
+void writeCellsFile(Tissue* T, const std::string& filename_cells)
+{
+	Polygons cells;
+	fillCells(T, cells);
+	writePolygonsVTK(cells, filename_cells, "Graph");
+}
+
+void writeDirectorsFile(Tissue* T, const std::string& filename_directors)
+{
+	std::vector<float> directors;
+	fillDirectors(T, directors);
+	writeLinesVTK(directors, filename_directors);
+}
+
+void writeCellDefectsFile(Tissue*, const std::vector<Cell*>& c_def, const std::string& filename_c_def)
+{
+	Polygons defects;
+	fillCellDefects(c_def, defects);
+	writePolygonsVTK(defects, filename_c_def, "Defect");
+}
 
-	defectFile << "CELLS " << c_def.size() << " " << n << '\n';
-	for (Cell* c : c_def) 
+void writeVertexDefectsFile(Tissue*, const std::vector<Vertex*>& v_def, const std::string& filename_v_def)
+{
+	std::vector<float> defects;
+	fillVertexDefects(v_def, defects);
+	writePointsVTK(defects, filename_v_def);
+}
+
+void writeCellsFileVTU(Tissue* T, const std::string& filename_cells)
+{
+	Polygons cells;
+	fillCells(T, cells);
+	writePolygonsVTU(cells, filename_cells);
+}
+
+void writeDirectorsFileVTP(Tissue* T, const std::string& filename_directors)
+{
+	std::vector<float> directors;
+	fillDirectors(T, directors);
+	writeLinesVTP(directors, filename_directors);
+}
+
+void writeCellDefectsFileVTU(const std::vector<Cell*>& c_def, const std::string& filename_c_def)
+{
+	Polygons defects;
+	fillCellDefects(c_def, defects);
+	writePolygonsVTU(defects, filename_c_def);
+}
+
+void writeVertexDefectsFileVTP(const std::vector<Vertex*>& v_def, const std::string& filename_v_def)
+{
+	std::vector<float> defects;
+	fillVertexDefects(v_def, defects);
+	writePointsVTP(defects, filename_v_def);
+}
+
+void writeFrame(const Frame& f)
+{
+	static const char* defect_names[4] = { "PLUSHALF", "PLUSONE", "MINUSHALF", "MINUSONE" };
+	std::string step = std::to_string(f.timestep);
+	if (f.binary)
 	{
-		defectFile << c->vertices().size() << " ";
-		for (Vertex* v : c->vertices()) { defectFile << index_map[v-v_0] << " "; }
-		defectFile << '\n'; 
+		writePolygonsVTU(f.cells, f.title + "cells" + step + ".vtu");
+		writeLinesVTP(f.directors, f.title + "directors" + step + ".vtp");
+		for (int i = 0; i < 4; i++) writePolygonsVTU(f.c_def[i], f.title + "cell defects " + defect_names[i] + step + ".vtu");
+		for (int i = 0; i < 4; i++) writePointsVTP(f.v_def[i], f.title + "vertex defects " + defect_names[i] + step + ".vtp");
 	}
-		
-	defectFile << "CELL_TYPES " << c_def.size() << '\n';
-	for (int c = 0; c < c_def.size(); c++) { defectFile << "7\n"; }
-		   
-	defectFile.close();
-}
-
-void writeVertexDefectsFile(Tissue* T, const std::vector<Vertex*>& v_def, const std::string& filename_v_def)
-{
-	std::ofstream file(filename_v_def);
-	size_t n = v_def.size();
-    file << "# vtk DataFile Version 2.0\nPoint data\nASCII\nDATASET POLYDATA\n";
-    file << "POINTS " << n << " float\n";
-    for (Vertex* v : v_def) file << v->r().x() << " " << v->r().y() << " 0\n";
-    
-    file << "VERTICES " << n << " " << 2 * n << "\n";
-    for (int i = 0; i < n; i++) file << "1 " << i << "\n";
-        
-    file.close();
+	else
+	{
+		writePolygonsVTK(f.cells, f.title + "cells" + step + ".vtk", "Graph");
+		writeLinesVTK(f.directors, f.title + "directors" + step + ".vtk");
+		for (int i = 0; i < 4; i++) writePolygonsVTK(f.c_def[i], f.title + "cell defects " + defect_names[i] + step + ".vtk", "Defect");
+		for (int i = 0; i < 4; i++) writePointsVTK(f.v_def[i], f.title + "vertex defects " + defect_names[i] + step + ".vtk");
+	}
+}
+
+void runEnsemble(const CellMesh& mesh, bool (*in)(const Point&), const std::vector<Parameters>& params, int timesteps, int threads, const std::function<void(Tissue&)>& setup)
+{
+	ThreadPool pool(threads);
+	std::atomic<int> next(0);
+	pool.run([&](int)
+	{
+		for (int i = next++; i < static_cast<int>(params.size()); i = next++)
+		{
+			std::unique_ptr<Tissue> T(new Tissue(mesh, in));
+			T->setParameters(params[i]);
+			setup(*T);
+			T->run(timesteps, std::to_string(i));
+			std::cout << std::to_string(i) + " run success\n";
+		}
+	});
 }
@@ -20,56 +20,52 @@ bool square(const Point& p)		{ return std::fabs(p.x()) < std::sqrt(1000)/2 && st
 bool unbound(const Point& p) 	{ return true; }
 bool circle(const Point& p) 	{ return (p.x()-0)*(p.x()-0) + (p.y()-0)*(p.y()-0) < 700; }
 
-//some example voronoi seeds
-std::vector<Point> randomPoints(unsigned int n) 
-{ 
-	std::vector<Point> points;
-	double w = std::sqrt(n);
-	for (int i = 0; i < n; i++) points.push_back(Point(w*((static_cast<double>(std::rand())/RAND_MAX)-0.5), w*((static_cast<double>(std::rand())/RAND_MAX)-0.5)));
-	return points;
-}
-std::vector<Point> hexagonalWithNoise(unsigned int n, double g)
-{
-	std::vector<Point> points;
-	double k = std::sqrt(n);
-	for (int i = -k/2; i < k/2; i++)
-	{
-		for (int j = -k/2; j < k/2; j++)
-		{
-			Point p(i+g*((static_cast<double>(std::rand())/RAND_MAX)-0.5), j+0.5*(i%2)+g*((static_cast<double>(std::rand())/RAND_MAX)-0.5));
-			points.push_back(p);
-		}
-	}
-	return points;
-}
-
-
 int main() 
 {
 	unsigned int cell_count = 2800;
     std::vector<Point> points = hexagonalWithNoise(cell_count, 0.1);
     //std::vector<Point> points = randomPoints(cell_count);
-    DT delauney_tri; 
-    delauney_tri.insert(points.begin(), points.end()); 		//Delauney triangulation from points
-    VD voronoi_diagram(delauney_tri); 						//Voronoi diagram dual to Delauney triangulation
+    CellMesh voronoi_cells = voronoiCells(points); 			//cells of the Voronoi diagram of the points
+    //CellMesh voronoi_cells = hexagonalCells(cell_count); 	//regular lattice without noise, needs no triangulation
 
 	/*auto t_start1 = std::chrono::high_resolution_clock::now();
-	Tissue T = Tissue(voronoi_diagram, circle);
+	Tissue T = Tissue(voronoi_cells, circle);
     auto t_end1 = std::chrono::high_resolution_clock::now();
     std::cout << "DATA COLLECTED IN " << std::chrono::duration<double, std::milli>(t_end1 - t_start1).count()/1000 << "s\n";*/
     
     unsigned int timesteps = 100000;
-    param::set_GAMMA(0.2);
-    param::set_LAMBDA(-0.2);
-    int i = 0;
+    unsigned int threads = 1; 								//threads used for each timestep, results do not depend on this
+    bool edge_forces = false; 								//edge-centric force assembly, forces are reset every timestep
+    bool adaptive = false; 									//time step chosen from how fast edges change, between dt and dt_max
+    int snapshot_interval = 0; 								//timesteps between vtk snapshots, 0 for none
+    bool binary_output = true; 								//snapshots as binary .vtu/.vtp, false for legacy ASCII .vtk
+    int snapshot_buffers = 2; 								//snapshots in flight to the writer thread before a timestep has to wait
+    int checkpoint_interval = 10000; 						//timesteps between checkpoints, a run resumes with Tissue T("<i>checkpoint.bin")
+    int defect_interval = 1; 								//timesteps between defect counts, 0 for none
+    int defect_decimation = 1; 								//counts averaged into each row of the defect file
+    bool binary_defects = false; 							//defect counts as binary rows instead of text columns
+    int metrics_interval = 0; 								//timesteps between rows of phase timings and event counts, 0 for none
+    bool json_metrics = false; 								//metrics as json lines instead of csv
+    int ensemble_threads = 8; 								//tissues of the LAMBDA sweep run at the same time
+    
+    std::vector<Parameters> sweep;
     for (double LAMBDA = -0.5; LAMBDA < 0.21; LAMBDA += 0.1)
     {
-		Tissue T = Tissue(voronoi_diagram, circle);
-		param::set_LAMBDA(LAMBDA);
-		T.run(timesteps, std::to_string(i));
-		i++;
-		std::cout << LAMBDA << " run success\n";
+		Parameters p;
+		p.set_GAMMA(0.2);
+		p.set_LAMBDA(LAMBDA);
+		sweep.push_back(p);
 	}
+	runEnsemble(voronoi_cells, circle, sweep, timesteps, ensemble_threads, [&](Tissue& T)
+	{
+		T.setThreads(threads);
+		T.setEdgeForces(edge_forces);
+		T.setAdaptive(adaptive);
+		T.setSnapshots(snapshot_interval, binary_output, snapshot_buffers);
+		T.setCheckpoints(checkpoint_interval);
+		T.setDefectRecording(defect_interval, defect_decimation, binary_defects);
+		T.setMetrics(metrics_interval, json_metrics);
+	});
     /*std::cout << "\nPRESS ENTER TO RUN SIMULATION"; std::cin.get();
     auto t_start2 = std::chrono::high_resolution_clock::now();
     T.run(timesteps, "");
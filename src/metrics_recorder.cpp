@@ -0,0 +1,78 @@
+#include <filesystem>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include "metrics_recorder.h"
+
+static const char* const PHASE_NAMES[PHASES] = { "transitions", "geometry", "forces", "integration", "calcm", "defects", "output", "T1" };
+
+
+MetricsRecorder::MetricsRecorder(const std::string& filename, int interval, bool json, const uint64_t* resume) :
+	filename_(filename), interval_(std::max(interval, 1)), json_(json), bytes_(0), steps_(0), cell_steps_(0)
+{
+	phase_.fill(0);
+	if (resume != nullptr && *resume > 0 && std::filesystem::exists(filename))
+	{
+		std::filesystem::resize_file(filename, *resume); 		//rows written after the checkpoint are dropped
+		file_.open(filename, std::ios::app);
+		bytes_ = *resume;
+	}
+	else
+	{
+		file_.open(filename, std::ios::trunc);
+		if (!json_)
+		{
+			std::ostringstream header;
+			header << "timestep,time,steps_per_s,cell_updates_per_s";
+			for (const char* name : PHASE_NAMES) header << ",s_" << name;
+			header << ",T1,T1_split,divisions,extrusions,vertices_created,vertices_destroyed,edges_created,edges_destroyed,cells_created,cells_destroyed,vertices,edges,cells\n";
+			write(header.str());
+		}
+	}
+	if (!file_) throw std::runtime_error("could not open metrics file " + filename);
+	last_ = row_start_ = Clock::now();
+}
+
+void MetricsRecorder::write(const std::string& text)
+{
+	file_ << text;
+	file_.flush(); 			//rows are rare, so they are on disk as soon as they are recorded
+	if (!file_) throw std::runtime_error("could not write metrics file " + filename_);
+	bytes_ += text.size();
+}
+
+void MetricsRecorder::record(int timestep, double time, const TopologyEvents& events, int vertices, int edges, int cells)
+{
+	Clock::time_point now = Clock::now();
+	double wall = std::chrono::duration<double>(now - row_start_).count();
+	double steps_per_s = steps_ > 0 ? steps_/wall : 0;
+	double cell_updates_per_s = steps_ > 0 ? cell_steps_/wall : 0;
+	long counts[13] = { events.T1, events.T1_split, events.divisions, events.extrusions, events.vertices_created, events.vertices_destroyed,
+						events.edges_created, events.edges_destroyed, events.cells_created, events.cells_destroyed, vertices, edges, cells };
+
+	//phase times are per timestep so rows of different intervals compare
+	std::ostringstream row;
+	if (json_)
+	{
+		static const char* const COUNT_NAMES[13] = { "T1", "T1_split", "divisions", "extrusions", "vertices_created", "vertices_destroyed",
+													 "edges_created", "edges_destroyed", "cells_created", "cells_destroyed", "vertices", "edges", "cells" };
+		row << "{\"timestep\": " << timestep << ", \"time\": " << time << ", \"steps_per_s\": " << steps_per_s << ", \"cell_updates_per_s\": " << cell_updates_per_s << ", \"phase_s\": {";
+		for (int i = 0; i < PHASES; i++) row << (i > 0 ? ", " : "") << '"' << PHASE_NAMES[i] << "\": " << (steps_ > 0 ? phase_[i]/steps_ : 0);
+		row << '}';
+		for (int i = 0; i < 13; i++) row << ", \"" << COUNT_NAMES[i] << "\": " << counts[i];
+		row << "}\n";
+	}
+	else
+	{
+		row << timestep << ',' << time << ',' << steps_per_s << ',' << cell_updates_per_s;
+		for (int i = 0; i < PHASES; i++) row << ',' << (steps_ > 0 ? phase_[i]/steps_ : 0);
+		for (long count : counts) row << ',' << count;
+		row << '\n';
+	}
+	write(row.str());
+
+	phase_.fill(0);
+	steps_ = 0; cell_steps_ = 0;
+	row_start_ = now;
+}
@@ -1,20 +1,26 @@
 #include "parameters.h"
 
-namespace param
+Parameters::Parameters()
 {
-	const double dt = 1e-6;
-	const double a = 0.2;
-	const double A_0 = 1.0;
-	const double K_a = 10.0;
+	dt = 1e-6;
+	dt_max = 1e-3;
+	step_fraction = 0.1;
+	a = 0.2;
+	A_0 = 1.0;
+	K_a = 10.0;
 	
-	const double l_min = 0.005*std::sqrt(A_0);
-	const double l_new = 0.01*std::sqrt(A_0);
-	const double A_min = 0.1*A_0;
-	const double A_max = 2.0*A_0;
+	l_min = 0.005*std::sqrt(A_0);
+	t1_skin = 10*l_min;
+	l_new = 0.01*std::sqrt(A_0);
+	A_min = 0.1*A_0;
+	A_max = 2.0*A_0;
 	
-	double LAMBDA = 0;
-	double GAMMA = 0.4*K_a*A_0;
+	LAMBDA = 0;
+	GAMMA = 0.4*K_a*A_0;
 	
-	void set_LAMBDA(double LAMBDA_) { LAMBDA = LAMBDA_*K_a*std::powf(A_0, 1.5); }
-	void set_GAMMA(double GAMMA_) { GAMMA = GAMMA_*K_a*A_0; }
+	D = 0;
+	seed = 1;
 }
+
+void Parameters::set_LAMBDA(double LAMBDA_) { LAMBDA = LAMBDA_*K_a*std::pow(A_0, 1.5); }
+void Parameters::set_GAMMA(double GAMMA_) { GAMMA = GAMMA_*K_a*A_0; }
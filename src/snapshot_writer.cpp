@@ -0,0 +1,72 @@
+#include <algorithm>
+
+#include "snapshot_writer.h"
+#include "functions.h"
+
+
+SnapshotWriter::SnapshotWriter(int buffers) : writing_(false), stop_(false)
+{
+	for (int i = 0; i < std::max(buffers, 1); i++)
+	{
+		frames_.emplace_back(new Frame());
+		free_.push_back(frames_.back().get());
+	}
+	thread_ = std::thread(&SnapshotWriter::work, this);
+}
+SnapshotWriter::~SnapshotWriter()
+{
+	flush();
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	changed_.notify_all();
+	thread_.join();
+}
+
+Frame* SnapshotWriter::acquire()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	changed_.wait(lock, [this] { return !free_.empty(); });
+	Frame* frame = free_.front();
+	free_.pop_front();
+	return frame;
+}
+
+void SnapshotWriter::submit(Frame* frame)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		queued_.push_back(frame);
+	}
+	changed_.notify_all();
+}
+
+void SnapshotWriter::flush()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	changed_.wait(lock, [this] { return queued_.empty() && !writing_; });
+}
+
+void SnapshotWriter::work()
+{
+	while (true)
+	{
+		Frame* frame;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			changed_.wait(lock, [this] { return stop_ || !queued_.empty(); });
+			if (queued_.empty()) return;
+			frame = queued_.front();
+			queued_.pop_front();
+			writing_ = true;
+		}
+		writeFrame(*frame);
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			free_.push_back(frame);
+			writing_ = false;
+		}
+		changed_.notify_all();
+	}
+}
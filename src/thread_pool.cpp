@@ -0,0 +1,55 @@
+#include "thread_pool.h"
+
+#define SPIN_COUNT 4000
+
+
+ThreadPool::ThreadPool(int n_threads) : job_(nullptr), generation_(0), pending_(0), stop_(false)
+{
+	for (int t = 1; t < n_threads; t++) workers_.emplace_back(&ThreadPool::work, this, t);
+}
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+		generation_++;
+	}
+	start_.notify_all();
+	for (std::thread& w : workers_) w.join();
+}
+
+const int ThreadPool::size() const { return workers_.size()+1; }
+
+void ThreadPool::run(const std::function<void(int)>& job)
+{
+	if (workers_.empty()) { job(0); return; }
+	job_ = &job;
+	pending_.store(workers_.size(), std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		generation_.fetch_add(1, std::memory_order_release);
+	}
+	start_.notify_all();
+	job(0);
+	while (pending_.load(std::memory_order_acquire) != 0) std::this_thread::yield();
+}
+
+void ThreadPool::work(int t)
+{
+	int seen = 0;
+	while (true)
+	{
+		//spin briefly since phases follow each other closely, then sleep until the next job
+		int spins = 0;
+		while (generation_.load(std::memory_order_acquire) == seen && ++spins < SPIN_COUNT) {}
+		if (generation_.load(std::memory_order_acquire) == seen)
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			start_.wait(lock, [this, seen] { return generation_.load(std::memory_order_acquire) != seen; });
+		}
+		seen = generation_.load(std::memory_order_acquire);
+		if (stop_) return;
+		(*job_)(t);
+		pending_.fetch_sub(1, std::memory_order_release);
+	}
+}
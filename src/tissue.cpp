@@ -1,135 +1,185 @@
-#include "tissue.h"
+#include <boost/math/constants/constants.hpp>
 
-void removeDuplicates(std::vector<Edge*>& vec) {
-    std::unordered_set<Edge*> seen;   // To track seen elements
-    auto it = vec.begin();
-
-    while (it != vec.end()) {
-        // If the element is seen for the first time, keep it
-        if (seen.insert(*it).second) {
-            ++it;
-        } else {
-            // Otherwise, erase the duplicate
-            it = vec.erase(it);
-        }
-    }
-}
+#include "tissue.h"
+#include "model.h"
 
-Tissue::Tissue(VD& vd, bool (*in)(const Point&)) : v_0_(v_arr.data()), e_0_(e_arr.data()), c_0_(c_arr.data()), timestep(0)
+Tissue::Tissue(const CellMesh& mesh, bool (*in)(const Point&), int n_threads) : pool_(new ThreadPool(std::max(n_threads, 1))), edge_forces_(false), snapshot_interval_(0), binary_output_(true), checkpoint_interval_(0), adaptive_(false), defect_interval_(1), defect_decimation_(1), binary_defects_(false), defect_resume_(), metrics_interval_(0), metrics_json_(false), metrics_resume_(0), timestep(0), time_(0), running_(false), resumed_(false), moved_(INFINITY), step_moved_(0), epoch_(0)
 {
-	v_in = {false};
-	e_in = {false};
-	c_in = {false};
-	v_c_ = v_0_;
-	e_c_ = e_0_;
-	c_c_ = c_0_;
-	
-	def_PLUSHALF_c = {0};
-	def_PLUSONE_c = {0};
-	def_MINUSHALF_c = {0};
-	def_MINUSONE_c = {0};
-	
 	std::cout << "COLLECTING INITIAL DATA\n";
-	for (VD::Vertex_iterator vit = vd.vertices_begin(); vit != vd.vertices_end(); vit++) createVertex(vit->point());
+	std::vector<Vertex*> mesh_vertices;
+	mesh_vertices.reserve(mesh.vertices.size());
+	for (const Point& r : mesh.vertices) mesh_vertices.push_back(createVertex(r));
     
-    for (VD::Face_iterator fi = vd.faces_begin(); fi != vd.faces_end(); fi++) 
+	std::vector<Vertex*> cell_vertices;
+	std::vector<Edge*> cell_edges; 
+    for (const std::vector<int>& face : mesh.faces) 
     {
-        std::vector<Vertex*> cell_vertices;
-        VD::Ccb_halfedge_circulator ec_start = fi->ccb();
-        VD::Ccb_halfedge_circulator ec = ec_start;
-        
-        do { 
-			if (!ec->is_unbounded()) 
-			{
-				for (Vertex* v = v_0_; v < v_c_; v++)
-				{
-					if (v_in[v-v_0_])
-					{
-						if (ec->source()->point() == v->r())
-						{
-							cell_vertices.push_back(v);
-							break;
-						}
-					}
-				}
-			}
-			++ec;
-        } while (ec != ec_start);
+		cell_vertices.clear(); cell_edges.clear();
+        for (int i : face) cell_vertices.push_back(mesh_vertices[i]);
 		
-		std::vector<Edge*> cell_edges; 
 		size_t n = cell_vertices.size();
 		for (int i = 0; i < n; i++)
 		{
 			Vertex* v_1 = cell_vertices[i]; 
 			Vertex* v_2 = cell_vertices[(i+1)%n];
-			bool found = false;
-			for (Edge* e = e_0_; e < e_c_; e++)
-			{
-				if (e_in[e-e_0_])
-				{
-					if ( (e->v1() == v_1 && e->v2() == v_2) || (e->v1() == v_2 && e->v2() == v_1) )
-					{
-						cell_edges.push_back(e);
-						found = true;
-						break;
-					}
-				}
-			}
-			if (!found) cell_edges.push_back(createEdge(v_1, v_2));
+			Edge* e = nullptr; 		//the neighbouring cell may have made the edge already, a vertex only has a few to look through
+			for (Edge* f : v_1->edgeContacts()) if (f->hasVertex(v_2)) e = f;
+			if (e == nullptr) e = createEdge(v_1, v_2);
+			cell_edges.push_back(e);
 		}
-		
-		removeDuplicates(cell_edges); //temporary fix
         createCell(cell_vertices, cell_edges);
     } 
     
-	std::unordered_set<Cell*> cells_to_remove;
-	for (Vertex* v = v_0_; v < v_c_; v++)
+	std::vector<bool> remove(c_arr.size(), false);
+	for (Vertex* v : v_arr.live())
 	{
-		if (!in(v->r())) cells_to_remove.insert(v->cellContacts().begin(), v->cellContacts().end());
+		if (!in(v->r())) for (Cell* c : v->cellContacts()) remove[c->id()] = true;
 	}
-	for (Cell* c = c_0_; c < c_c_; c++)
+	std::vector<Cell*> cells_to_remove;
+	for (Cell* c : c_arr.live())
 	{
-		if (c->edges().size() < 3) cells_to_remove.insert(c);
+		if (remove[c->id()]) cells_to_remove.push_back(c);
 	}
 	for (Cell* c : cells_to_remove) destroyCell(c);
 	    
-    for (Cell* c = c_0_; c < c_c_; c++) if (c_in[c-c_0_]) c->findNeighbours(); 			//cells find neighbours
-	for (Vertex* v = v_0_; v < v_c_; v++) if (v_in[v-v_0_]) v->orderCellContacts();		//vertices order cell contacts
+	pool_->forEach(v_arr.live(), [](Vertex* v) { v->orderCellContacts(); }); 		//vertices order cell contacts
+	pool_->forEach(c_arr.live(), [](Cell* c) { c->findNeighbours(); }); 			//cells find neighbours from the vertex orders
+	recycle();
 	
 	//sanity check using Euler characteristic: we expect Euler = 1
 	int V = vertices().size(); int E = edges().size(); int C = cells().size();
 	int Euler = V-E+C;
     std::cout << "V=" << V << "\nE=" << E << "\nC=" << C << "\nV-E+C=" << Euler << '\n';
+    events_ = TopologyEvents(); 			//building the tissue is not counted
+}
+namespace
+{
+	template <typename T>
+	void saveSlab(CheckpointOut& out, const Slab<T>& arr)
+	{
+		out.put(arr.size());
+		out.put(arr.liveSlots());
+		out.put(arr.freeSlots());
+	}
+	template <typename T>
+	void restoreSlab(CheckpointIn& in, Slab<T>& arr)
+	{
+		int size = in.get<int>();
+		std::vector<int> live_slots, free_slots;
+		in.get(live_slots); in.get(free_slots);
+		arr.restore(size, live_slots, free_slots);
+	}
+	
 }
-Tissue::~Tissue() {}
 
-const bool Tissue::v_alive(Vertex* v) const { return v_in[v-v_0_]; }
+Tissue::Tissue(const std::string& checkpoint) : pool_(new ThreadPool(1)), edge_forces_(false), snapshot_interval_(0), binary_output_(true), checkpoint_interval_(0), adaptive_(false), defect_interval_(1), defect_decimation_(1), binary_defects_(false), defect_resume_(), metrics_interval_(0), metrics_json_(false), metrics_resume_(0), timestep(0), time_(0), running_(false), resumed_(false), moved_(INFINITY), step_moved_(0), epoch_(0)
+{
+	CheckpointIn in(checkpoint);
+	if (in.get<int>() != CHECKPOINT_VERSION) throw std::runtime_error("unsupported checkpoint version in " + checkpoint);
+	param_ = in.get<Parameters>();
+	timestep = in.get<int>();
+	time_ = in.get<double>();
+	defect_resume_ = in.get<DefectRecorder::State>();
+	metrics_resume_ = in.get<uint64_t>();
+	events_ = in.get<TopologyEvents>();
+	resumed_ = in.get<bool>();
+	
+	//storage layout first so every id already has an address when pointers are resolved
+	restoreSlab(in, v_arr);
+	restoreSlab(in, e_arr);
+	restoreSlab(in, c_arr);
+	for (int i : v_arr.liveSlots()) v_arr[i].load(in, this, i);
+	for (int i : e_arr.liveSlots()) e_arr[i].load(in, this, i);
+	for (int i : c_arr.liveSlots()) c_arr[i].load(in, this, i);
+	
+	//only positions, topology and edge lengths are stored, everything derived from them is recalculated
+	for (Vertex* v : v_arr.live()) v->orderCellContacts();
+	for (Cell* c : c_arr.live()) c->findNeighbours();
+	for (Cell* c : c_arr.live())
+	{
+		c->calcL();
+		c->calcA();
+		c->calcG();
+	}
+	for (Edge* e : e_arr.live()) e->calcTurn();
+	for (Cell* c : c_arr.live()) c->calcm();
+	for (Vertex* v : v_arr.live()) v->calcm();
+	for (Vertex* v : v_arr.live()) if (v->edgeContacts().size() == 4) watchFourfold(v);
+}
 
-std::vector<Vertex*> Tissue::vertices()
+void Tissue::writeCheckpoint(const std::string& filename) const
 {
-	std::vector<Vertex*> vertices;
-	for (Vertex* v = v_0_; v < v_c_; v++) if (v_in[v-v_0_]) vertices.push_back(v);
-	return vertices;
+	CheckpointOut out;
+	out.put(CHECKPOINT_VERSION);
+	out.put(param_);
+	out.put(timestep);
+	out.put(time_);
+	out.put(defects_ ? defects_->state() : defect_resume_); 		//the defect file is flushed up to this timestep
+	out.put(metrics_ ? metrics_->bytes() : metrics_resume_);
+	out.put(events_);
+	out.put(running_); 			//the boundary flags saved below are only refreshed when a run starts
+	
+	saveSlab(out, v_arr);
+	saveSlab(out, e_arr);
+	saveSlab(out, c_arr);
+	for (Vertex* v : v_arr.live()) v->save(out);
+	for (Edge* e : e_arr.live()) e->save(out);
+	for (Cell* c : c_arr.live()) c->save(out);
+	out.write(filename);
 }
-std::vector<Edge*> Tissue::edges()
+
+Tissue::~Tissue() {}
+
+void Tissue::setThreads(int n_threads) { pool_.reset(new ThreadPool(std::max(n_threads, 1))); }
+const int Tissue::threads() const { return pool_->size(); }
+void Tissue::setEdgeForces(bool edge_forces) { edge_forces_ = edge_forces; }
+void Tissue::setCheckpoints(int interval) { checkpoint_interval_ = interval; }
+void Tissue::setDefectRecording(int interval, int decimation, bool binary) { defect_interval_ = interval; defect_decimation_ = decimation; binary_defects_ = binary; }
+void Tissue::setMetrics(int interval, bool json) { metrics_interval_ = interval; metrics_json_ = json; }
+void Tissue::setAdaptive(bool adaptive) { adaptive_ = adaptive; }
+const double Tissue::time() const { return time_; }
+const TopologyEvents& Tissue::events() const { return events_; }
+const double Tissue::uniform(int stream, int id, int draw) const { return Philox::uniform(param_.seed, stream, id, timestep, draw); }
+const Vec Tissue::normal(int stream, int id, int draw) const { return Philox::normal2(param_.seed, stream, id, timestep, draw); }
+void Tissue::setParameters(const Parameters& param) { param_ = param; }
+const Parameters& Tissue::param() const { return param_; }
+void Tissue::setSnapshots(int interval, bool binary, int buffers)
 {
-	std::vector<Edge*> edges;
-	for (Edge* e = e_0_; e < e_c_; e++) if (e_in[e-e_0_]) edges.push_back(e);
-	return edges;
+	snapshot_interval_ = interval;
+	binary_output_ = binary;
+	writer_.reset(interval > 0 ? new SnapshotWriter(buffers) : nullptr);
 }
-std::vector<Cell*> Tissue::cells()
+
+const bool Tissue::v_alive(Vertex* v) const { return v_arr.alive(v->id()); }
+const int Tissue::v_index(Vertex* v) const { return v_arr.position(v->id()); }
+
+const std::vector<Vertex*>& Tissue::vertices() const { return v_arr.live(); }
+const std::vector<Edge*>& Tissue::edges() const { return e_arr.live(); }
+const std::vector<Cell*>& Tissue::cells() const { return c_arr.live(); }
+
+Vertex* const Tissue::v_at(int id) { return (id < 0) ? nullptr : &v_arr[id]; }
+Edge* const Tissue::e_at(int id) { return (id < 0) ? nullptr : &e_arr[id]; }
+Cell* const Tissue::c_at(int id) { return (id < 0) ? nullptr : &c_arr[id]; }
+HalfEdge* const Tissue::h_at(int id) { return (id < 0) ? nullptr : e_arr[id/2].h(id%2); }
+void Tissue::watchEdge(Edge* e)
 {
-	std::vector<Cell*> cells;
-	for (Cell* c = c_0_; c < c_c_; c++) if (c_in[c-c_0_]) cells.push_back(c);
-	return cells;
+	if (moved_ == INFINITY) return; 		//everything is scanned at the next rebuild anyway
+	if (static_cast<size_t>(e->id()) >= e_watched_.size()) e_watched_.resize(e_arr.size(), false);
+	if (e_watched_[e->id()]) return;
+	e_watched_[e->id()] = true;
+	short_watch_.push_back(e);
+}
+void Tissue::watchLoop(Cell* c) { geometry_.touch(c->id()); }
+void Tissue::watchVertex(Vertex* v) { for (Edge* e : v->edgeContacts()) watchEdge(e); }
+void Tissue::watchFourfold(Vertex* v)
+{
+	if (static_cast<size_t>(v->id()) >= v_watched_.size()) v_watched_.resize(v_arr.size(), false);
+	if (v_watched_[v->id()]) return;
+	v_watched_[v->id()] = true;
+	fourfold_watch_.push_back(v);
 }
 
-Vertex* const Tissue::v_0() const { return v_0_; }
-Edge* const Tissue::e_0() const { return e_0_; }
-Cell* const Tissue::c_0() const { return c_0_; }
-Vertex* const Tissue::v_c() const { return v_c_; }
-Edge* const Tissue::e_c() const { return e_c_; }
-Cell* const Tissue::c_c() const { return c_c_; }
+const int Tissue::h_id(const HalfEdge* h) const { return (h == nullptr) ? -1 : 2*h->e->id() + (h == h->e->h(1)); }
 
 const std::vector<Cell*>& Tissue::c_def_PLUSHALF() const { return c_def_PLUSHALF_; }
 const std::vector<Cell*>& Tissue::c_def_PLUSONE() const { return c_def_PLUSONE_; }
@@ -146,271 +196,450 @@ void Tissue::findDefects()
 	c_def_PLUSONE_ = {};
 	c_def_MINUSHALF_ = {};
 	c_def_MINUSONE_ = {};
-	for (Cell* c = c_0_; c < c_c_; c++)
+	for (Cell* c : c_arr.live())
 	{
-		if (c_in[c-c_0_])
-		{
-			double m = c->m();
-			if 		(std::fabs(m - 0.5) < 1e-3) c_def_PLUSHALF_.push_back(c); 
-			else if (std::fabs(m - 1) < 1e-3) c_def_PLUSONE_.push_back(c); 
-			else if (std::fabs(m + 0.5) < 1e-3) c_def_MINUSHALF_.push_back(c); 
-			else if (std::fabs(m + 1) < 1e-3) c_def_MINUSONE_.push_back(c); 
-		}
+		double m = c->m();
+		if 		(std::fabs(m - 0.5) < 1e-3) c_def_PLUSHALF_.push_back(c); 
+		else if (std::fabs(m - 1) < 1e-3) c_def_PLUSONE_.push_back(c); 
+		else if (std::fabs(m + 0.5) < 1e-3) c_def_MINUSHALF_.push_back(c); 
+		else if (std::fabs(m + 1) < 1e-3) c_def_MINUSONE_.push_back(c); 
 	}
 	
 	v_def_PLUSHALF_ = {};
 	v_def_PLUSONE_ = {};
 	v_def_MINUSHALF_ = {};
 	v_def_MINUSONE_ = {};
-	for (Vertex* v = v_0_; v < v_c_; v++)
+	for (Vertex* v : v_arr.live())
 	{
-		if (v_in[v-v_0_])
-		{
-			double m = v->m();
-			if 		(std::fabs(m - 0.5) < 1e-3) v_def_PLUSHALF_.push_back(v); 
-			else if (std::fabs(m - 1) < 1e-3) v_def_PLUSONE_.push_back(v); 
-			else if (std::fabs(m + 0.5) < 1e-3) v_def_MINUSHALF_.push_back(v); 
-			else if (std::fabs(m + 1) < 1e-3) v_def_MINUSONE_.push_back(v); 
-		}
+		double m = v->m();
+		if 		(std::fabs(m - 0.5) < 1e-3) v_def_PLUSHALF_.push_back(v); 
+		else if (std::fabs(m - 1) < 1e-3) v_def_PLUSONE_.push_back(v); 
+		else if (std::fabs(m + 0.5) < 1e-3) v_def_MINUSHALF_.push_back(v); 
+		else if (std::fabs(m + 1) < 1e-3) v_def_MINUSONE_.push_back(v); 
 	}
 }
 
-void Tissue::countDefects()
+const std::array<int, 4> Tissue::countDefects() const
 {
-	for (Cell* c = c_0_; c < c_c_; c++)
-	{
-		if (c_in[c-c_0_])
-		{
-			double m = c->m();
-			if 		(std::fabs(m - 0.5) < 1e-3) def_PLUSHALF_c[timestep]++; 
-			else if (std::fabs(m - 1) < 1e-3) def_PLUSONE_c[timestep]++; 
-			else if (std::fabs(m + 0.5) < 1e-3) def_MINUSHALF_c[timestep]++; 
-			else if (std::fabs(m + 1) < 1e-3) def_MINUSONE_c[timestep]++; 
-		}
-	}
-	for (Vertex* v = v_0_; v < v_c_; v++)
+	std::array<int, 4> counts = {0, 0, 0, 0};
+	auto count = [&counts](double m)
 	{
-		if (v_in[v-v_0_])
-		{
-			double m = v->m();
-			if 		(std::fabs(m - 0.5) < 1e-3) def_PLUSHALF_c[timestep]++; 
-			else if (std::fabs(m - 1) < 1e-3) def_PLUSONE_c[timestep]++; 
-			else if (std::fabs(m + 0.5) < 1e-3) def_MINUSHALF_c[timestep]++; 
-			else if (std::fabs(m + 1) < 1e-3) def_MINUSONE_c[timestep]++; 
-		}
-	}
+		if 		(std::fabs(m - 0.5) < 1e-3) counts[0]++; 
+		else if (std::fabs(m - 1) < 1e-3) counts[1]++; 
+		else if (std::fabs(m + 0.5) < 1e-3) counts[2]++; 
+		else if (std::fabs(m + 1) < 1e-3) counts[3]++; 
+	};
+	for (Cell* c : c_arr.live()) count(c->m());
+	for (Vertex* v : v_arr.live()) count(v->m());
+	return counts;
 }
 
 Vertex* const Tissue::createVertex(Point r)
 {
-	*v_c_ = Vertex(this, r); v_in[v_c_-v_0_] = true;
-	return v_c_++; 																	//return id of created vertex
+	int i = v_arr.allocate();
+	events_.vertices_created++;
+	return v_arr.construct(i, this, i, r); 											//return id of created vertex
 }
 Edge* const Tissue::createEdge(Vertex* v1, Vertex* v2)
 {	
-	v1->addEdgeContact(e_c_);														//vertex v1 knows it's part of edge
-	v2->addEdgeContact(e_c_);														//vertex v1 knows it's part of edge
-	*e_c_ = Edge(this, v1, v2); e_in[e_c_-e_arr.data()] = true;
-	return e_c_++; 																	//return id of created edge
+	int i = e_arr.allocate();
+	events_.edges_created++;
+	Edge* e = e_arr.construct(i, this, i, v1, v2);
+	v1->addEdgeContact(e);															//vertex v1 knows it's part of edge
+	v2->addEdgeContact(e);															//vertex v1 knows it's part of edge
+	watchEdge(e);
+	return e; 																		//return id of created edge
 }
 Cell* const Tissue::createCell(std::vector<Vertex*>& vertices, std::vector<Edge*>& edges)
 {
-	for (Vertex* v : vertices) v->addCellContact(c_c_);								//vertices know they are part of cell
-	for (Edge* e : edges) e->addCellJunction(c_c_);									//edges know they are part of cell	
-	*c_c_ = Cell(this, vertices, edges); c_in[c_c_-c_0_] = true;	
-	return c_c_++; 																	//return id of created cell
+	//link the half-edges running along the cell's vertex order into a loop
+	size_t n = vertices.size();
+	for (size_t i = 0; i < n; i++) link(edges[i]->from(vertices[i]), edges[(i+1)%n]->from(vertices[(i+1)%n]));
+	return createCell(edges[0]->from(vertices[0]));
+}
+Cell* const Tissue::createCell(HalfEdge* h)
+{
+	int i = c_arr.allocate();
+	events_.cells_created++;
+	Cell* c = c_arr.construct(i, this, i, h); 										//cell claims the half-edges of its loop
+	geometry_.touch(i);
+	for (HalfEdge* h : c->halfEdges()) h->v->addCellContact(c);						//vertices know they are part of cell
+	return c; 																		//return id of created cell
+}
+
+void Tissue::recycle()
+{
+	v_arr.recycle();
+	e_arr.recycle();
+	c_arr.recycle();
 }
 
-void Tissue::destroyVertex(Vertex* v) { v_in[v-v_0_] = false; }
+void Tissue::destroyVertex(Vertex* v) { v_arr.release(v->id()); events_.vertices_destroyed++; }
 void Tissue::destroyEdge(Edge* e) 
 { 
-	for (Cell* c : e->cellJunctions()) c->removeEdge(e);
 	e->v1()->removeEdgeContact(e);
 	e->v2()->removeEdgeContact(e);
-	e_in[e-e_0_] = false;
+	e_arr.release(e->id());
+	events_.edges_destroyed++;
 }
 void Tissue::destroyCell(Cell* c)
 {
-	for (Vertex* v : c->vertices()) v->removeCellContact(c);
-	for (Edge* e : c->edges()) e->removeCellJunction(c);
-	c_in[c-c_0_] = false;
+	std::vector<HalfEdge*> loop;
+	for (HalfEdge* h : c->halfEdges()) loop.push_back(h);
+	for (HalfEdge* h : loop)
+	{
+		h->c = nullptr; h->next = nullptr; h->prev = nullptr;
+		h->v->removeCellContact(c);
+	}
+	for (HalfEdge* h : loop) if (h->twin->c == nullptr) destroyEdge(h->e); 		//edges left without cells are removed
+	c_arr.release(c->id());
+	geometry_.touch(c->id());
+	events_.cells_destroyed++;
 }
 
 
-void Tissue::cellNewVertex(Cell* c, Vertex* v, int i) 
-{ 
-	c->addVertex(v, i);
-	v->addCellContact(c);
+void Tissue::unlink(HalfEdge* h)
+{
+	Cell* c = h->c;
+	geometry_.touch(c->id());
+	if (c->h() == h) c->setH(h->next);
+	link(h->prev, h->next);
+	h->c = nullptr; h->next = nullptr; h->prev = nullptr;
+}
+void Tissue::insertAfter(HalfEdge* h_prev, HalfEdge* h)
+{
+	HalfEdge* h_next = h_prev->next;
+	geometry_.touch(h_prev->c->id());
+	link(h_prev, h); link(h, h_next);
+	h->c = h_prev->c;
 }
-void Tissue::cellRemoveVertex(Cell* c, Vertex* v) { c->removeVertex(v); }
-void Tissue::cellExchangeVertex(Cell* c, Vertex* v_old, Vertex* v_new) { c->exchangeVertex(v_old, v_new); }
 
-void Tissue::cellNewEdge(Cell* c, Edge* e, int i)
+Vertex* const Tissue::splitEdge(Edge* e, Point r)
 {
-	c->addEdge(e, i);
-	e->addCellJunction(c);	
+	Vertex* v_1 = e->v1(); Vertex* v_2 = e->v2();
+	HalfEdge* h_1 = e->from(v_1); HalfEdge* h_2 = e->from(v_2);
+	
+	//e keeps v_1 -> v, new edge f covers v -> v_2
+	Vertex* v = createVertex(r);
+	Edge* f = createEdge(v, v_2);
+	e->swapVertex(v_2, v);
+	if (h_1->c != nullptr) 
+	{ 
+		insertAfter(h_1, f->from(v)); 
+		v->addCellContact(h_1->c);
+	}
+	if (h_2->c != nullptr) 
+	{ 
+		insertAfter(h_2->prev, f->from(v_2)); 
+		v->addCellContact(h_2->c);
+	}
+	return v;
 }
-int Tissue::cellRemoveEdge(Cell* c, Edge* e) { return c->removeEdge(e); }
 
-const double Tissue::D_angle(Cell* c_i, Cell* c_j) const
+Cell* const Tissue::splitCell(Cell* c, HalfEdge* h_1, HalfEdge* h_2)
+{
+	Vertex* v_1 = h_1->v; Vertex* v_2 = h_2->v;
+	HalfEdge* p_1 = h_1->prev; HalfEdge* p_2 = h_2->prev;
+	Edge* e = createEdge(v_1, v_2);
+	HalfEdge* g_1 = e->from(v_1); HalfEdge* g_2 = e->from(v_2);
+	
+	//c keeps h_1 ... p_2 closed by v_2 -> v_1, the new cell gets h_2 ... p_1 closed by v_1 -> v_2
+	geometry_.touch(c->id());
+	link(p_2, g_2); link(g_2, h_1); g_2->c = c;
+	link(p_1, g_1); link(g_1, h_2);
+	c->setH(h_1);
+	
+	Cell* c_new = createCell(h_2);
+	for (HalfEdge* h : c_new->halfEdges()) if (h->v != v_1 && h->v != v_2) h->v->removeCellContact(c);
+	return c_new;
+}
+
+const double Tissue::winding(const std::vector<Cell*>& loop, const std::vector<Edge*>& between) const
 {	
-	double Z_i = c_i->Z(); double X_i = c_i->X(); double S_i = std::sqrt(X_i*X_i+Z_i*Z_i);
-	double Z_j = c_j->Z(); double X_j = c_j->X(); double S_j = std::sqrt(X_j*X_j+Z_j*Z_j);
-	return std::asin( (Z_i*X_j-X_i*Z_j) / (S_i*S_j) );
+	//turns are cached on edges, pairs without a shared edge are worked out here
+	size_t n = loop.size();
+	auto turn = [&loop, &between, n](size_t i, double& s, double& c)
+	{
+		Cell* c_i = loop[i]; Cell* c_j = loop[(i+1)%n];
+		if (between[i] != nullptr) { s = between[i]->turnS(c_i); c = between[i]->turnC(); return; }
+		s = c_i->Zn()*c_j->Xn() - c_i->Xn()*c_j->Zn();
+		c = c_i->Zn()*c_j->Zn() + c_i->Xn()*c_j->Xn();
+	};
+	
+	//while every step is less than a quarter turn asin is the turn itself, so the sum is a whole number of turns
+	//and is counted from the steps crossing the positive Z axis, asin is only needed when a larger step folds back
+	int turns = 0;
+	bool quarter = true;
+	for (size_t i = 0; i < n && quarter; i++)
+	{
+		double s, c;
+		turn(i, s, c);
+		quarter = c > 0;
+		double x_i = loop[i]->Xn(); double x_j = loop[(i+1)%n]->Xn();
+		if (x_i < 0 && x_j >= 0 && s > 0) turns++;
+		else if (x_i >= 0 && x_j < 0 && s < 0) turns--;
+	}
+	if (quarter) return turns;
+	
+	double w = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		double s, c;
+		turn(i, s, c);
+		w += std::asin(s);
+	}
+	return w*boost::math::constants::one_div_two_pi <double>();
 }
 
 
-void Tissue::extrusion()
+void Tissue::extrusion(const std::vector<Cell*>& small_cells, std::vector<Cell*>& large_cells)
 {	
-	std::vector<Cell*> small_cells;
-	for (Cell* c = c_0_; c < c_c_; c++)
+	//a cell conflicts with an accepted one exactly when one of its vertices touches it, so accepted cells are marked
+	c_mark_.resize(c_arr.size(), -1);
+	epoch_++;
+	std::vector<Cell*> accepted;
+	for (Cell* c : small_cells)
 	{
-		if (c_in[c-c_0_])
+		bool contact = false;
+		for (HalfEdge* h : c->halfEdges())
 		{
-			if (c->A() < param::A_min)
-			{
-				const std::vector<Vertex*>& vertices = c->vertices();
-				int j = 0; bool contact = false;
-				while (j < vertices.size() && !contact)
-				{
-					for (Cell* v_cell : vertices[j]->cellContacts())
-					{
-						std::vector<Cell*>::const_iterator it = std::find(small_cells.begin(), small_cells.end(), v_cell);
-						if (it != small_cells.end()) contact = true;
-					}
-					j++;
-				}
-				if (!contact) small_cells.push_back(c);
-			}
+			for (Cell* v_cell : h->v->cellContacts()) contact |= mark(v_cell);
+			if (contact) break;
 		}
+		if (contact) continue;
+		c_mark_[c->id()] = epoch_;
+		accepted.push_back(c);
 	}
-	for (Cell* c : small_cells) c->extrude();
+	if (accepted.empty()) return;
+	
+	//only cells sharing a vertex with an extruded cell change shape
+	std::vector<Cell*> touched;
+	for (Cell* c : accepted) for (HalfEdge* h : c->halfEdges()) for (Cell* v_cell : h->v->cellContacts()) touched.push_back(v_cell);
+	for (Cell* c : accepted) events_.extrusions += c->extrude();
+	
+	epoch_++;
+	std::vector<Cell*> candidates;
+	for (Cell* c : touched)
+	{
+		if (!c_arr.alive(c->id()) || mark(c)) continue;
+		c_mark_[c->id()] = epoch_;
+		c->calcA();
+		if (c->A() > param_.A_max) candidates.push_back(c);
+	}
+	for (Cell* c : large_cells) if (c_arr.alive(c->id()) && !mark(c)) candidates.push_back(c);
+	std::sort(candidates.begin(), candidates.end(), [this](Cell* c_1, Cell* c_2) { return c_arr.position(c_1->id()) < c_arr.position(c_2->id()); });
+	large_cells.swap(candidates);
 }
 
-void Tissue::division()
+void Tissue::division(const std::vector<Cell*>& large_cells)
 {	
-	std::vector<Cell*> large_cells;
-	for (Cell* c = c_0_; c < c_c_; c++)
+	c_mark_.resize(c_arr.size(), -1);
+	epoch_++;
+	std::vector<Cell*> accepted;
+	for (Cell* c : large_cells)
 	{
-		if (c_in[c-c_0_])
+		bool contact = false;
+		for (HalfEdge* h : c->halfEdges())
 		{
-			if (c->A() > param::A_max)
-			{
-				const std::vector<Vertex*>& vertices = c->vertices();
-				int j = 0; bool contact = false;
-				while (j < vertices.size() && !contact)
-				{
-					for (Cell* v_cell : vertices[j]->cellContacts())
-					{
-						std::vector<Cell*>::const_iterator it = std::find(large_cells.begin(), large_cells.end(), v_cell);
-						if (it != large_cells.end()) contact = true;
-					}
-					j++;
-				}
-				if (!contact) large_cells.push_back(c);
-			}
+			for (Cell* v_cell : h->v->cellContacts()) contact |= mark(v_cell);
+			if (contact) break;
 		}
+		if (contact) continue;
+		c_mark_[c->id()] = epoch_;
+		accepted.push_back(c);
 	}
-	for (Cell* c : large_cells) c->divide();
+	for (Cell* c : accepted) events_.divisions += c->divide();
+	
+	//both daughters and the cells across the split edges share a vertex with the first daughter
+	for (Cell* c : accepted) for (HalfEdge* h : c->halfEdges()) for (Cell* v_cell : h->v->cellContacts()) v_cell->calcA();
 }
 
 void Tissue::transitions()
 {	
-	for (int c = 0; c < c_c_-c_0_; c++) if (c_in[c]) c_arr[c].calcA();
-	extrusion();
-	for (int c = 0; c < c_c_-c_0_; c++) if (c_in[c]) c_arr[c].calcA();
-	division();
+	//the only whole tissue area pass of the step, cells past either threshold are queued in the order of cells()
+	//and the areas of cells changed by extrusion or division are recalculated, so every area is current afterwards
+	std::vector<Cell*> events = pool_->filter(c_arr.live(), [this](Cell* c)
+	{
+		c->calcA();
+		return c->A() < param_.A_min || c->A() > param_.A_max;
+	});
+	std::vector<Cell*> small_cells, large_cells;
+	for (Cell* c : events) (c->A() < param_.A_min ? small_cells : large_cells).push_back(c);
+	extrusion(small_cells, large_cells);
+	division(large_cells);
+}
+
+void Tissue::rebuildShortWatch()
+{
+	short_watch_.clear();
+	e_watched_.assign(e_arr.size(), false);
+	double l_watch = param_.l_min + param_.t1_skin;
+	for (Edge* e : e_arr.live())
+	{
+		if (e->l() < l_watch) { short_watch_.push_back(e); e_watched_[e->id()] = true; }
+	}
 }
 
+const bool Tissue::mark(Cell* c) const { return c != nullptr && c_mark_[c->id()] == epoch_; }
+
 void Tissue::T1()
 {
+	if (moved_ > param_.t1_skin) { rebuildShortWatch(); moved_ = step_moved_; } 		//lengths were calculated before this step's move
+	
+	//short edges in the order of edges(), dropping dead and long edges since they only return through watchEdge
 	std::vector<Edge*> short_edges;
-	for (Edge* e = e_0_; e < e_c_; e++)
+	size_t n = 0;
+	for (Edge* e : short_watch_)
+	{
+		if (!e_arr.alive(e->id()) || e->l() >= param_.l_min + param_.t1_skin) { e_watched_[e->id()] = false; continue; }
+		short_watch_[n++] = e;
+		if (e->l() < param_.l_min) short_edges.push_back(e);
+	}
+	short_watch_.resize(n);
+	std::sort(short_edges.begin(), short_edges.end(), [this](Edge* e_1, Edge* e_2) { return e_arr.position(e_1->id()) < e_arr.position(e_2->id()); });
+	
+	//an edge conflicts with an accepted one exactly when they share a cell, so accepted edges mark their cells
+	c_mark_.resize(c_arr.size(), -1);
+	epoch_++;
+	n = 0;
+	for (Edge* e : short_edges)
+	{
+		const SmallSet<Cell*, 2> cells = e->cellJunctions();
+		bool contact = false;
+		for (Cell* c : cells) contact |= mark(c);
+		if (contact) continue;
+		for (Cell* c : cells) c_mark_[c->id()] = epoch_;
+		short_edges[n++] = e;
+	}
+	short_edges.resize(n);
+	for (Edge* e : short_edges) events_.T1 += e->T1();
+	
+	//vertices that are still fourfold stay watched, e.g. on the boundary where they are not split
+	std::vector<Vertex*> fourfold_vertices;
+	n = 0;
+	for (Vertex* v : fourfold_watch_)
+	{
+		if (!v_arr.alive(v->id()) || v->edgeContacts().size() != 4) { v_watched_[v->id()] = false; continue; }
+		fourfold_watch_[n++] = v;
+		fourfold_vertices.push_back(v);
+	}
+	fourfold_watch_.resize(n);
+	std::sort(fourfold_vertices.begin(), fourfold_vertices.end(), [this](Vertex* v_1, Vertex* v_2) { return v_arr.position(v_1->id()) < v_arr.position(v_2->id()); });
+	for (Vertex* v : fourfold_vertices) events_.T1_split += v->T1split();
+}
+
+template <typename Model>
+double Tissue::adaptiveStep()
+{
+	//steps are small enough that an edge is seen below l_min, and so gets a T1, before it can shrink through zero
+	double dt = pool_->reduce(e_arr.live(), param_.dt_max, [this](Edge* e) { return e->maxStep<Model>(param_); }, [](double a, double b) { return std::min(a, b); });
+	return std::max(dt, param_.dt);
+}
+
+void Tissue::writeSnapshot(const std::string& title)
+{
+	//only copying into the frame holds up the timestep, the files are written by the writer thread
+	findDefects();
+	Frame* f = writer_->acquire();
+	f->title = title;
+	f->timestep = timestep;
+	f->binary = binary_output_;
+	fillCells(this, f->cells);
+	fillDirectors(this, f->directors);
+	
+	fillCellDefects(c_def_PLUSHALF_, f->c_def[0]);
+	fillCellDefects(c_def_PLUSONE_, f->c_def[1]);
+	fillCellDefects(c_def_MINUSHALF_, f->c_def[2]);
+	fillCellDefects(c_def_MINUSONE_, f->c_def[3]);
+	fillVertexDefects(v_def_PLUSHALF_, f->v_def[0]);
+	fillVertexDefects(v_def_PLUSONE_, f->v_def[1]);
+	fillVertexDefects(v_def_MINUSHALF_, f->v_def[2]);
+	fillVertexDefects(v_def_MINUSONE_, f->v_def[3]);
+	writer_->submit(f);
+}
+
+template <typename Model>
+void Tissue::runPhase(int phase)
+{
+	//each phase only writes to the entity it is called on, so they can be split across threads
+	if (phase == PHASE_TRANSITIONS)
 	{
-		if (e_in[e-e_0_])
+		recycle();
+		transitions();
+	}
+	else if (phase == PHASE_GEOMETRY) geometry_.update<Model>(v_arr, e_arr, c_arr, *pool_, param_); 		//edge lengths and cell shapes, areas are already current after transitions()
+	else if (phase == PHASE_FORCES)
+	{
+		pool_->forEach(e_arr.live(), [this](Edge* e) { e->calcT_l<Model>(param_); });
+		if (edge_forces_)
 		{
-			if (e->l() < param::l_min)
-			{
-				const std::unordered_set<Cell*>& cells = e->cellJunctions();
-				bool contact = false;
-				for (Cell* c : cells)
-				{
-					for (Edge* c_edge : c->edges())
-					{
-						std::vector<Edge*>::const_iterator it = std::find(short_edges.begin(), short_edges.end(), c_edge);
-						if (it != short_edges.end()) { contact = true; break; }
-					}
-				}
-				if (!contact) short_edges.push_back(e);
-			}
+			//each edge computes its force terms once, vertices then sum those of their edges
+			pool_->forEach(e_arr.live(), [](Edge* e) { e->calcForce(); });
+			pool_->forEach(v_arr.live(), [](Vertex* v) { v->gatherForce(); });
 		}
+		else pool_->forEach(v_arr.live(), [](Vertex* v) { v->calcForce(); });
+	}
+	else if (phase == PHASE_INTEGRATION)
+	{
+		double dt = adaptive_ ? adaptiveStep<Model>() : param_.dt;
+		double step = pool_->reduce(v_arr.live(), 0.0, [this, dt](Vertex* v) { return v->applyForce<Model>(param_, dt); }, [](double a, double b) { return std::max(a, b); });
+		step_moved_ = 2*std::sqrt(step); 			//an edge changes length by at most the distance both its vertices moved
+		moved_ += step_moved_;
+		time_ += dt;
 	}
-	for (Edge* e : short_edges) { e->T1(); }
-	std::vector<int> fourfold_vertices;
-	for (int v = 0; v < v_c_-v_0_; v++) if (v_in[v]) if (v_arr[v].edgeContacts().size() == 4) fourfold_vertices.push_back(v);
-	for (int v : fourfold_vertices) v_arr[v].T1split();
+	else if (phase == PHASE_CALCM)
+	{
+		pool_->forEach(e_arr.live(), [](Edge* e) { e->calcTurn(); }); 		//each neighbouring pair is turned through once for both windings
+		pool_->forEach(c_arr.live(), [](Cell* c) { c->calcm(); });
+		pool_->forEach(v_arr.live(), [](Vertex* v) { v->calcm(); });
+	}
+	else if (phase == PHASE_DEFECTS) { if (defects_ && defects_->due(timestep)) defects_->record(timestep, countDefects()); }
+	else if (phase == PHASE_T1) T1();
+	else throw std::runtime_error("phase " + std::to_string(phase) + " does not run on its own");
 }
 
+template <typename Model>
 void Tissue::run(int max_timestep, std::string title)
 {
-	for (int v = 0; v < v_c_-v_0_; v++) if (v_in[v]) v_arr[v].onBoundaryCell();
+	//boundary flags are refreshed as a run starts, except when resuming a run that was interrupted, which was still
+	//using the flags from its own start
+	if (!resumed_) for (Vertex* v : v_arr.live()) v->onBoundaryCell();
+	resumed_ = false;
+	running_ = true;
+	if (defect_interval_ > 0 && !defects_)
+	{
+		defects_.reset(new DefectRecorder(title + (binary_defects_ ? "defects.bin" : "defects.txt"), defect_interval_, defect_decimation_, binary_defects_, timestep > 0 ? &defect_resume_ : nullptr));
+	}
+	if (metrics_interval_ > 0 && !metrics_) metrics_.reset(new MetricsRecorder(title + (metrics_json_ ? "metrics.json" : "metrics.csv"), metrics_interval_, metrics_json_, timestep > 0 ? &metrics_resume_ : nullptr));
 	while (timestep < max_timestep)
 	{
-		if (timestep % 1000 == 0) std::cout << timestep << '\n';
-		transitions();
-		
-        for (int e = 0; e < e_c_-e_0_; e++) if (e_in[e]) e_arr[e].calcLength();
-        for (int c = 0; c < c_c_-c_0_; c++)
-        {
-			if (c_in[c])
-			{
-				c_arr[c].calcL();
-				c_arr[c].calcA();
-				c_arr[c].calcT_A();
-				c_arr[c].calcG();
-			}
+		if (!metrics_ && timestep % 1000 == 0) std::cout << timestep << '\n';
+		if (metrics_) metrics_->startStep();
+		for (int phase = PHASE_TRANSITIONS; phase <= PHASE_DEFECTS; phase++)
+		{
+			runPhase<Model>(phase);
+			if (metrics_) metrics_->lap(phase);
 		}
-		
-		for (int e = 0; e < e_c_-e_0_; e++) if (e_in[e]) e_arr[e].calcT_l();
-		for (int v = 0; v < v_c_-v_0_; v++) if (v_in[v]) v_arr[v].calcForce();
-		for (int v = 0; v < v_c_-v_0_; v++) if (v_in[v]) v_arr[v].applyForce();
-		
-		for (int c = 0; c < c_c_-c_0_; c++) if (c_in[c]) c_arr[c].calcm();
-		for (int v = 0; v < v_c_-v_0_; v++) if (v_in[v]) v_arr[v].calcm();
-		countDefects();
         
-		/*if (timestep % 20 == 0)
-		{
-			findDefects();
-			writeCellsFile(this, "cells" + std::to_string(timestep) + ".vtk");
-			writeDirectorsFile(this, "directors" + std::to_string(timestep) + ".vtk");
-			
-			writeCellDefectsFile(this, c_def_PLUSHALF_, "cell defects PLUSHALF" + std::to_string(timestep) + ".vtk");
-			writeCellDefectsFile(this, c_def_PLUSONE_, "cell defects PLUSONE" + std::to_string(timestep) + ".vtk");
-			writeCellDefectsFile(this, c_def_MINUSHALF_, "cell defects MINUSHALF" + std::to_string(timestep) + ".vtk");
-			writeCellDefectsFile(this, c_def_MINUSONE_, "cell defects MINUSONE" + std::to_string(timestep) + ".vtk");
-			writeVertexDefectsFile(this, v_def_PLUSHALF_, "vertex defects PLUSHALF" + std::to_string(timestep) + ".vtk");
-			writeVertexDefectsFile(this, v_def_PLUSONE_, "vertex defects PLUSONE" + std::to_string(timestep) + ".vtk");
-			writeVertexDefectsFile(this, v_def_MINUSHALF_, "vertex defects MINUSHALF" + std::to_string(timestep) + ".vtk");
-			writeVertexDefectsFile(this, v_def_MINUSONE_, "vertex defects MINUSONE" + std::to_string(timestep) + ".vtk");
-		}*/
-		T1();
+		if (snapshot_interval_ > 0 && timestep % snapshot_interval_ == 0) writeSnapshot(title);
+		if (metrics_) metrics_->lap(PHASE_OUTPUT);
+		runPhase<Model>(PHASE_T1);
         timestep++;	
+        if (metrics_)
+        {
+			metrics_->lap(PHASE_T1);
+			metrics_->endStep(c_arr.count());
+			if (metrics_->due(timestep)) metrics_->record(timestep, time_, events_, v_arr.count(), e_arr.count(), c_arr.count());
+		}
+		//after the metrics row of this timestep, the file length saved with the checkpoint includes it
+        if (checkpoint_interval_ > 0 && timestep % checkpoint_interval_ == 0) writeCheckpoint(title + "checkpoint.bin");
+		if (metrics_) metrics_->lap(PHASE_OUTPUT);
 	}
-	std::ofstream plushalf(title + "PLUSHALF.txt");
-	for (int i = 0; i < max_timestep; i++) plushalf << def_PLUSHALF_c[i] << "\n";
-	plushalf.close();
-	
-	std::ofstream plusone(title + "PLUSONE.txt");
-	for (int i = 0; i < max_timestep; i++) plusone << def_PLUSONE_c[i] << "\n";
-	plusone.close();
-	
-	std::ofstream minushalf(title + "MINUSHALF.txt");
-	for (int i = 0; i < max_timestep; i++) minushalf << def_MINUSHALF_c[i] << "\n";
-	minushalf.close();
-	
-	std::ofstream minusone(title + "MINUSONE.txt");
-	for (int i = 0; i < max_timestep; i++) minusone << def_MINUSONE_c[i] << "\n";
-	minusone.close();
-	
+	running_ = false;
+	if (writer_) writer_->flush();
+	if (defects_) defects_->flush();
 }
+
+#define INSTANTIATE(Model) template void Tissue::run<Model>(int, std::string); template void Tissue::runPhase<Model>(int);
+FOR_EACH_MODEL(INSTANTIATE)
+#undef INSTANTIATE
@@ -2,7 +2,7 @@
 #include "tissue.h"
 
 
-Vertex::Vertex(Tissue* T, Point r) : T(T), r_(r), force_(Vec(0,0)) 
+Vertex::Vertex(Tissue* T, int id, Point r) : T(T), id_(id), r_(r), force_(Vec(0,0)) 
 { 
 	not_boundary_cell = 1; 
 	cell_contacts_ordered.reserve(8);
@@ -21,34 +21,57 @@ bool Vertex::onBoundaryCell()
 	return false;
 }
 
+const int Vertex::id() const { return id_; }
 const Point& Vertex::r() const { return r_; }
 const double Vertex::m() const { return m_; }
-const std::unordered_set<Cell*>& Vertex::cellContacts() const { return cell_contacts_; }
-const std::unordered_set<Edge*>& Vertex::edgeContacts() const { return edge_contacts_; }
+const SmallSet<Cell*, 4>& Vertex::cellContacts() const { return cell_contacts_; }
+const SmallSet<Edge*, 4>& Vertex::edgeContacts() const { return edge_contacts_; }
+const std::vector<Cell*>& Vertex::orderedCellContacts() const { return cell_contacts_ordered; }
+const std::vector<Edge*>& Vertex::contactEdges() const { return contact_edges_; }
+
+HalfEdge* const Vertex::out(Cell* c)
+{
+	for (Edge* e : edge_contacts_) 
+	{
+		HalfEdge* h = e->from(this);
+		if (h->c == c) return h;
+	}
+	return nullptr;
+}
+
+void Vertex::setR(const Point& r) { r_ = r; T->watchVertex(this); }
 
 void Vertex::addCellContact(Cell* c) { cell_contacts_.insert(c); }
 void Vertex::removeCellContact(Cell* c) { cell_contacts_.erase(c); }
 
-void Vertex::addEdgeContact(Edge* e) { edge_contacts_.insert(e); }
+void Vertex::addEdgeContact(Edge* e) 
+{ 
+	edge_contacts_.insert(e); 
+	if (edge_contacts_.size() == 4) T->watchFourfold(this);
+}
 void Vertex::removeEdgeContact(Edge* e) 
 {
 	edge_contacts_.erase(e);
 	if (edge_contacts_.size() == 0) T->destroyVertex(this);
+	else if (edge_contacts_.size() == 4) T->watchFourfold(this);
 }
 
 
 Vec Vertex::calcSurfaceForce()
 {
 	Vec f_A(0,0);
-	for (Cell* c : cell_contacts_) 
+	for (Edge* e : edge_contacts_) 
 	{
-		const std::vector<Vertex*>& c_vertices = c->vertices();
-		int n = c_vertices.size(); int S = c->S();
-		std::vector<Vertex*>::const_iterator it = std::find(c_vertices.begin(), c_vertices.end(), this);
-		int j = std::distance(c_vertices.begin(), it);
+		//each cell at the vertex has exactly one half-edge leaving it, which gives the neighbouring polygon corners
+		HalfEdge* h = e->from(this);
+		Cell* c = h->c;
+		if (c == nullptr) continue;
+		int S = c->S();
+		const Point& r_next = h->twin->v->r();
+		const Point& r_prev = h->prev->v->r();
 		
-		double dAdx = S*0.5*(c_vertices[(j+1)%n]->r().y() - c_vertices[(j-1+n)%n]->r().y());
-		double dAdy = S*0.5*(c_vertices[(j-1+n)%n]->r().x() - c_vertices[(j+1)%n]->r().x());
+		double dAdx = S*0.5*(r_next.y() - r_prev.y());
+		double dAdy = S*0.5*(r_prev.x() - r_next.x());
 		f_A -= c->T_A()*Vec(dAdx, dAdy);
 	}
 	return f_A;
@@ -72,109 +95,112 @@ Vec Vertex::calcLineForce()
 }
 
 void Vertex::calcForce() { force_ += calcSurfaceForce()+calcLineForce(); }
-void Vertex::applyForce() { r_ += not_boundary_cell*param::a*param::dt*force_ + 100*(1-not_boundary_cell)*param::a*param::dt*Vec(-r_.y(),r_.x()); }
+void Vertex::gatherForce()
+{
+	force_ = Vec(0,0);
+	for (Edge* e : edge_contacts_) force_ += e->force(this);
+}
 void Vertex::shearForce() { force_ = Vec(-r_.y(),r_.x()); } //anticlockwise shear
 
 
+//half-edge leaving the same vertex in the next cell round it, across the edge before h if before is set, nullptr at the boundary
+static HalfEdge* turn(HalfEdge* h, bool before)
+{
+	HalfEdge* g = before ? h->prev->twin : h->twin;
+	if (g->c == nullptr) return nullptr;
+	return before ? g : g->next;
+}
+
 void Vertex::orderCellContacts()
 {
-	std::vector<std::pair<Cell*, double>> contacts;
-	for (Cell* c : cell_contacts_) 
+	//cells round the vertex follow each other across its edges, so the anticlockwise order is read off the half-edges
+	//with anticlockwise cell loops the next cell anticlockwise is across the edge before, otherwise across the edge after
+	cell_contacts_ordered.clear(); contact_edges_.clear();
+	for (Cell* c_0 : cell_contacts_)
 	{
-		c->calcR_0();
-		Vec vec = c->r_0()-r_;
-		double theta = std::atan2(vec.y(), vec.x());
-		contacts.push_back({c,theta});
+		if (std::find(cell_contacts_ordered.begin(), cell_contacts_ordered.end(), c_0) != cell_contacts_ordered.end()) continue;
+		HalfEdge* h_0 = out(c_0);
+		if (h_0 == nullptr) { cell_contacts_ordered.push_back(c_0); contact_edges_.push_back(nullptr); continue; }
+		const bool ccw = c_0->S() > 0;
+		
+		//back to the boundary if there is one, so open fans are listed from one end
+		HalfEdge* h_start = h_0;
+		for (HalfEdge* h = turn(h_0, !ccw); h != nullptr && h != h_0; h = turn(h, !ccw)) h_start = h;
+		HalfEdge* h = h_start;
+		do 
+		{ 
+			cell_contacts_ordered.push_back(h->c);
+			Edge* e = (ccw ? h->prev : h)->e; 		//edge crossed to the next cell
+			h = turn(h, ccw);
+			contact_edges_.push_back(h != nullptr ? e : nullptr);
+		} while (h != nullptr && h != h_start);
 	}
-	
-	std::sort(contacts.begin(), contacts.end(), 
-		[](const std::pair<Cell*, double>& c1, const std::pair<Cell*, double>& c2) { return c1.second < c2.second; });
-	cell_contacts_ordered = contacts;
 }
 
-void Vertex::T1split()
+const bool Vertex::T1split()
 {
-	if (cell_contacts_.size() != 4 || edge_contacts_.size() != 4) return;
-	for (Cell* c : cell_contacts_) if (c->onBoundary()) return; 
+	if (cell_contacts_.size() != 4 || edge_contacts_.size() != 4) return false;
+	for (Cell* c : cell_contacts_) if (c->onBoundary()) return false; 
 	
 	//affected cells, a,b change vertex p,q gets new edge
 	orderCellContacts();
-	Cell* const c_a = cell_contacts_ordered[0].first; Cell* const c_b = cell_contacts_ordered[2].first;
-	Cell* const c_p = cell_contacts_ordered[1].first; Cell* const c_q = cell_contacts_ordered[3].first;
-
-	const std::vector<Vertex*>& c_p_vertices = c_p->vertices();
-	auto it_id = std::find(c_p_vertices.begin(), c_p_vertices.end(), this);
-	int i = std::distance(c_p_vertices.begin(), it_id);
+	Cell* const c_a = cell_contacts_ordered[0]; Cell* const c_b = cell_contacts_ordered[2];
+	Cell* const c_p = cell_contacts_ordered[1]; Cell* const c_q = cell_contacts_ordered[3];
 	
-	//new vertices
-	Vertex* v_a = nullptr; 
-	Vertex* v_b = nullptr;
-	auto updateAB = [this](Cell* const c_x, Vertex*& v_x)
-	{
-		//find position of and create vertex
-		c_x->calcR_0();
-		Vec vec_x = c_x->r_0() - r_;
-		Point x = r_ + 0.1*vec_x;
-		v_x = T->createVertex(x);
-
-		//attatch relevent edges to vertex
-		for (Edge* e : c_x->edges()) e->swapVertex(this, v_x);
-		if (!(c_x->valid())) c_x->rotateVertices();
-	};
-	updateAB(c_a, v_a); updateAB(c_b, v_b);
-
-	//edge that vertex is split into
-	Edge* const e_new = T->createEdge(v_a, v_b);
-
-	//update edges for cells p, q
-	auto updateEdges = [this, c_a, c_b, v_a, v_b, e_new](Cell* const c_x)
-	{
-		const std::vector<Vertex*>& c_x_vertices = c_x->vertices();
-		const std::vector<Edge*>& c_x_edges = c_x->edges();
-		size_t n = c_x_edges.size();
-		for (int i = 0; i < n; i++)
-		{
-			if (c_x_edges[i]->hasVertex(v_a) && c_x_edges[(i+1)%n]->hasVertex(v_b))
-			{
-				T->cellNewEdge(c_x, e_new, i+1);
-				break;
-			}
-			else if (c_x_edges[i]->hasVertex(v_b) && c_x_edges[(i+1)%n]->hasVertex(v_a))
-			{
-				T->cellNewEdge(c_x, e_new, i+1);
-				break;
-			}
-		}		
-	};
-	updateEdges(c_p); updateEdges(c_q);
+	//half-edges around the vertex in each cell, cells a and b must be opposite each other
+	HalfEdge* const b_out = out(c_b); HalfEdge* const b_in = b_out->prev;
+	HalfEdge* const p_out = out(c_p); HalfEdge* const p_in = p_out->prev;
+	HalfEdge* const q_out = out(c_q); HalfEdge* const q_in = q_out->prev;
+	if (b_out->twin->c == c_a || b_in->twin->c == c_a) return false;
+	
+	//this vertex moves towards c_a and a new vertex towards c_b takes the edges of c_b
+	c_a->calcR_0(); c_b->calcR_0();
+	Point a = r_ + 0.1*(c_a->r_0() - r_);
+	Point b = r_ + 0.1*(c_b->r_0() - r_);
+	Vertex* const v_b = T->createVertex(b);
+	Edge* const e_b_out = b_out->e; Edge* const e_b_in = b_in->e;
+	e_b_out->swapVertex(this, v_b); e_b_in->swapVertex(this, v_b);
 	
-	auto updateVertices = [this, c_a, c_b, v_a, v_b, e_new](Cell* const c_x, bool before)
+	//edge that vertex is split into, inserted into p and q on whichever side now touches v_b
+	Edge* const e_new = T->createEdge(this, v_b);
+	auto updateEdges = [this, v_b, e_new, e_b_out, e_b_in](HalfEdge* const x_in)
 	{
-		const std::vector<Vertex*>& c_x_vertices = c_x->vertices();
-		std::vector<Vertex*>::const_iterator it_va = std::find(c_x_vertices.begin(), c_x_vertices.end(), v_a);
-		
-		if (it_va != c_x_vertices.end())
-		{
-			int i = std::distance(c_x_vertices.begin(), it_va);
-			if (before) T->cellNewVertex(c_x, v_b, i);
-			else T->cellNewVertex(c_x, v_b, i+1);
-			while (!(c_x->valid())) c_x->rotateVertices();
-		}
+		if (x_in->e == e_b_out || x_in->e == e_b_in) T->insertAfter(x_in, e_new->from(v_b));
+		else T->insertAfter(x_in, e_new->from(this));
 	};
-	updateVertices(c_p, true); updateVertices(c_q, false);
-
-	T->destroyVertex(this);
-	v_a->orderCellContacts(); v_b->orderCellContacts();
-	for (Cell* c : v_a->cellContacts()) c->findNeighbours(); 
-	for (Cell* c : v_b->cellContacts()) c->findNeighbours();
+	updateEdges(p_in); updateEdges(q_in);
+	
+	removeCellContact(c_b);
+	v_b->addCellContact(c_b); v_b->addCellContact(c_p); v_b->addCellContact(c_q);
+	setR(a);
+	
+	orderCellContacts(); v_b->orderCellContacts();
+	c_a->findNeighbours(); c_b->findNeighbours(); c_p->findNeighbours(); c_q->findNeighbours();
 	//std::cout << "T1 split\n";
+	return true;
 }
 
 void Vertex::calcm()
 {
 	//cell order already known
-	size_t n = cell_contacts_.size();
-	double w = 0;
-	for (int i = 0; i < n; i++) w += T->D_angle(cell_contacts_ordered[i].first, cell_contacts_ordered[(i+1)%n].first);
-	m_ = w*boost::math::constants::one_div_two_pi <double>();
+	m_ = T->winding(cell_contacts_ordered, contact_edges_);
+}
+
+void Vertex::save(CheckpointOut& out) const
+{
+	out.put(r_); out.put(force_); out.put(not_boundary_cell);
+	out.put<int>(edge_contacts_.size());
+	for (Edge* e : edge_contacts_) out.put(e->id());
+	out.put<int>(cell_contacts_.size());
+	for (Cell* c : cell_contacts_) out.put(c->id());
+}
+
+void Vertex::load(CheckpointIn& in, Tissue* tissue, int id)
+{
+	T = tissue; id_ = id;
+	r_ = in.getVec2(); force_ = in.getVec2(); not_boundary_cell = in.get<int>();
+	edge_contacts_.clear();
+	for (int n = in.get<int>(); n > 0; n--) edge_contacts_.insert(T->e_at(in.get<int>()));
+	cell_contacts_.clear();
+	for (int n = in.get<int>(); n > 0; n--) cell_contacts_.insert(T->c_at(in.get<int>()));
 }
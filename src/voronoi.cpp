@@ -0,0 +1,85 @@
+#include <unordered_map>
+
+#include "libraries.h"
+
+
+CellMesh voronoiCells(const std::vector<Point>& seeds)
+{
+	std::vector<Site> sites;
+	sites.reserve(seeds.size());
+	for (const Point& p : seeds) sites.push_back(Site(p.x(), p.y()));
+	IndexedDT dt;
+	dt.insert(sites.begin(), sites.end()); 		//Delauney triangulation from points, sorted along a space filling curve first
+	CellMesh mesh;
+	if (dt.dimension() < 2) return mesh; 		//collinear seeds have no bounded cells
+	
+	//the cells are read straight off the triangulation, a voronoi vertex is the circumcentre of a delaunay face
+	//neighbouring faces on the same circle give the same vertex, they are merged like the degeneracy removal of VD
+	mesh.vertices.reserve(dt.number_of_faces());
+	for (IndexedDT::Face_handle f : dt.finite_face_handles()) f->info() = -1;
+	std::vector<IndexedDT::Face_handle> circle;
+	for (IndexedDT::Face_handle f : dt.finite_face_handles())
+	{
+		if (f->info() >= 0) continue;
+		int v = mesh.vertices.size();
+		Site r = dt.circumcenter(f);
+		mesh.vertices.push_back(Point(r.x(), r.y()));
+		f->info() = v; circle.push_back(f);
+		while (!circle.empty())
+		{
+			IndexedDT::Face_handle g = circle.back(); circle.pop_back();
+			for (int i = 0; i < 3; i++)
+			{
+				IndexedDT::Face_handle h = g->neighbor(i);
+				if (dt.is_infinite(h) || h->info() >= 0) continue;
+				if (dt.side_of_oriented_circle(g, h->vertex(h->index(g))->point()) != CGAL::ON_ORIENTED_BOUNDARY) continue;
+				h->info() = v; circle.push_back(h);
+			}
+		}
+	}
+	
+	//faces round a seed are anticlockwise, seeds on the convex hull touch the infinite vertex and have unbounded cells
+	mesh.faces.reserve(dt.number_of_vertices());
+	std::vector<int> face;
+	for (IndexedDT::Vertex_handle s : dt.finite_vertex_handles())
+	{
+		face.clear();
+		bool bounded = true;
+		IndexedDT::Face_circulator f = dt.incident_faces(s), f_start = f;
+		do
+		{
+			if (dt.is_infinite(f)) { bounded = false; break; }
+			if (face.empty() || face.back() != f->info()) face.push_back(f->info());
+		} while (++f != f_start);
+		if (!bounded) continue;
+		if (face.front() == face.back()) face.pop_back(); 		//merged vertex that wraps round the start
+		mesh.faces.push_back(face);
+	}
+	return mesh;
+}
+
+CellMesh voronoiCells(const VD& vd)
+{
+	CellMesh mesh;
+	
+	//voronoi vertices are identified by their dual delaunay face, so half-edge sources map straight to vertex indices
+	std::unordered_map<DT::Face_handle, int> vertex_map;
+	vertex_map.reserve(vd.number_of_vertices());
+	mesh.vertices.reserve(vd.number_of_vertices());
+	for (VD::Vertex_iterator vit = vd.vertices_begin(); vit != vd.vertices_end(); vit++)
+	{
+		vertex_map[vit->dual()] = mesh.vertices.size();
+		mesh.vertices.push_back(Point(vit->point().x(), vit->point().y()));
+	}
+	
+	for (VD::Face_iterator fi = vd.faces_begin(); fi != vd.faces_end(); fi++) 
+	{
+		if (fi->is_unbounded()) continue; 						//unbounded faces are not closed polygons
+		std::vector<int> face;
+		VD::Ccb_halfedge_circulator ec_start = fi->ccb();
+		VD::Ccb_halfedge_circulator ec = ec_start;
+		do { face.push_back(vertex_map.at(ec->source()->dual())); } while (++ec != ec_start);
+		mesh.faces.push_back(face);
+	}
+	return mesh;
+}
@@ -0,0 +1,94 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include "tissue.h"
+#include "functions.h"
+#include "parameters.h"
+
+//a run restored from a checkpoint has to end exactly where the uninterrupted run does, positions and event counts alike
+//the tissue proliferates so the restore has to carry vertices made by divisions since the start
+//the first run goes on past its checkpoint as if it crashed later, the rows it wrote after the checkpoint must not stay in the metrics file
+
+static bool everywhere(const Point& r) { return r.squared_length() < 150; }
+
+static Parameters dividing()
+{
+	Parameters p;
+	p.set_GAMMA(0.2);
+	p.set_LAMBDA(-0.3);
+	p.A_max = 1.05*p.A_0;
+	return p;
+}
+
+static void quiet(Tissue& T)
+{
+	T.setParameters(dividing());
+	T.setDefectRecording(0, 1, false);
+	T.setMetrics(100, false);
+}
+
+static std::vector<std::string> timesteps(const std::string& filename) 		//first column of every metrics row
+{
+	std::vector<std::string> column;
+	std::ifstream file(filename);
+	std::string line;
+	while (std::getline(file, line)) column.push_back(line.substr(0, line.find(',')));
+	return column;
+}
+
+static int compare(const Tissue& a, const Tissue& b)
+{
+	int failures = 0;
+	if (a.vertices().size() != b.vertices().size() || a.edges().size() != b.edges().size() || a.cells().size() != b.cells().size())
+	{
+		std::printf("entity counts differ: %zu %zu %zu vs %zu %zu %zu\n", a.vertices().size(), a.edges().size(), a.cells().size(), b.vertices().size(), b.edges().size(), b.cells().size());
+		return 1;
+	}
+	for (size_t i = 0; i < a.vertices().size(); i++)
+	{
+		const Vertex* u = a.vertices()[i]; const Vertex* v = b.vertices()[i];
+		if (u->id() != v->id() || u->r() != v->r())
+		{
+			if (failures++ < 5) std::printf("vertex %d at (%.17g, %.17g) vs %d at (%.17g, %.17g)\n", u->id(), u->r().x(), u->r().y(), v->id(), v->r().x(), v->r().y());
+		}
+	}
+	const TopologyEvents& e = a.events(); const TopologyEvents& f = b.events();
+	long counts_a[] = { e.T1, e.T1_split, e.divisions, e.extrusions, e.vertices_created, e.vertices_destroyed, e.edges_created, e.edges_destroyed, e.cells_created, e.cells_destroyed };
+	long counts_b[] = { f.T1, f.T1_split, f.divisions, f.extrusions, f.vertices_created, f.vertices_destroyed, f.edges_created, f.edges_destroyed, f.cells_created, f.cells_destroyed };
+	for (int i = 0; i < 10; i++) if (counts_a[i] != counts_b[i]) { std::printf("event counter %d: %ld vs %ld\n", i, counts_a[i], counts_b[i]); failures++; }
+	if (e.divisions == 0) { std::printf("no divisions, the test does not cover the restore of new vertices\n"); failures++; }
+	return failures;
+}
+
+int main()
+{
+	const int checkpoint_step = 500, steps = 1500;
+	CellMesh mesh = hexagonalCells(400);
+
+	Tissue straight(mesh, everywhere);
+	quiet(straight);
+	straight.run(steps, "checkpoint_test_straight_");
+
+	Tissue first(mesh, everywhere);
+	quiet(first);
+	first.setCheckpoints(checkpoint_step);
+	first.run(checkpoint_step + 200, "checkpoint_test_");
+	Tissue restored("checkpoint_test_checkpoint.bin");
+	restored.setDefectRecording(0, 1, false);
+	restored.setMetrics(100, false);
+	restored.run(steps, "checkpoint_test_");
+
+	int failures = compare(straight, restored);
+	if (timesteps("checkpoint_test_straight_metrics.csv") != timesteps("checkpoint_test_metrics.csv"))
+	{
+		std::printf("metrics rows of the restored run differ from the uninterrupted run\n");
+		failures++;
+	}
+	std::printf("%s: %d differences after %d steps, %ld divisions\n", failures == 0 ? "PASS" : "FAIL", failures, steps, straight.events().divisions);
+	std::remove("checkpoint_test_checkpoint.bin");
+	std::remove("checkpoint_test_metrics.csv");
+	std::remove("checkpoint_test_straight_metrics.csv");
+	return failures == 0 ? 0 : 1;
+}
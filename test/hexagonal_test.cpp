@@ -0,0 +1,53 @@
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <set>
+#include <utility>
+#include <algorithm>
+
+#include "functions.h"
+#include "voronoi.h"
+
+//hexagonalCells(n) has to give the voronoi cells CGAL gives for hexagonalWithNoise(n, 0), corner for corner
+//cells along the edge of the lattice are left out, the diagram leaves them unbounded or cut short there
+
+typedef std::vector<std::pair<long, long>> Corners; 		//sorted corner coordinates of a face, in millionths
+
+static Corners corners(const CellMesh& mesh, const std::vector<int>& face)
+{
+	Corners c;
+	for (int v : face) c.push_back({ std::lround(1e6*mesh.vertices[v].x()), std::lround(1e6*mesh.vertices[v].y()) });
+	std::sort(c.begin(), c.end());
+	return c;
+}
+
+int main()
+{
+	const unsigned int n = 100;
+	CellMesh lattice = hexagonalCells(n);
+	CellMesh diagram = voronoiCells(hexagonalWithNoise(n, 0));
+	int m = std::lround(std::sqrt(lattice.faces.size())); 		//faces run column by column, m to a column
+	int failures = 0;
+
+	std::set<std::pair<long, long>> distinct; 		//a corner shared by several cells is one vertex
+	for (int v = 0; v < static_cast<int>(lattice.vertices.size()); v++) distinct.insert({ std::lround(1e6*lattice.vertices[v].x()), std::lround(1e6*lattice.vertices[v].y()) });
+	if (distinct.size() != lattice.vertices.size()) { std::printf("%zu vertices at only %zu places\n", lattice.vertices.size(), distinct.size()); failures++; }
+
+	std::set<Corners> cells;
+	for (const std::vector<int>& face : diagram.faces) cells.insert(corners(diagram, face));
+	int interior = 0;
+	for (int f = 0; f < static_cast<int>(lattice.faces.size()); f++)
+	{
+		int column = f/m, row = f%m;
+		if (column == 0 || column == m-1 || row == 0 || row == m-1) continue;
+		interior++;
+		if (lattice.faces[f].size() != 6 || cells.count(corners(lattice, lattice.faces[f])) == 0)
+		{
+			if (failures++ < 5) std::printf("cell %d of column %d is not a cell of the voronoi diagram\n", row, column);
+		}
+	}
+	if (interior == 0) { std::printf("no interior cells to compare\n"); failures++; }
+
+	std::printf("%s: %d of %d interior cells differ\n", failures == 0 ? "PASS" : "FAIL", failures, interior);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+#include <cstdio>
+#include <array>
+#include <cstdint>
+
+#include "philox.h"
+
+//Philox4x32-10 has to give the known-answer outputs published with Random123 (kat_vectors), otherwise the noise of a
+//seed is not the generator the literature describes and runs would not be reproducible against other implementations
+
+struct Known
+{
+	uint64_t key; 						//k_1 in the high half
+	std::array<uint32_t, 4> counter;
+	std::array<uint32_t, 4> output;
+};
+
+int main()
+{
+	const Known vectors[] =
+	{
+		{ 0x0000000000000000ull, { 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u }, { 0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u } },
+		{ 0xffffffffffffffffull, { 0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu }, { 0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu } },
+		{ 0x299f31d0a4093822ull, { 0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u }, { 0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u } }
+	};
+
+	int failures = 0;
+	for (const Known& v : vectors)
+	{
+		std::array<uint32_t, 4> c = Philox::block(v.key, v.counter[0], v.counter[1], v.counter[2], v.counter[3]);
+		if (c != v.output)
+		{
+			std::printf("key %016llx gives %08x %08x %08x %08x, expected %08x %08x %08x %08x\n", static_cast<unsigned long long>(v.key),
+						c[0], c[1], c[2], c[3], v.output[0], v.output[1], v.output[2], v.output[3]);
+			failures++;
+		}
+	}
+	std::printf("%s: %d of 3 known answers differ\n", failures == 0 ? "PASS" : "FAIL", failures);
+	return failures == 0 ? 0 : 1;
+}